@@ -0,0 +1,478 @@
+// 64-bit off_t for fseeko/ftello on 32-bit targets. must come before any
+// system header.
+#define _FILE_OFFSET_BITS 64
+
+#include "chunkfile.h"
+#include <limits.h>
+#include <string.h>
+
+// scenes can be larger than memory, so file offsets can't go through long,
+// which is 32 bits on windows and 32-bit targets.
+#ifdef _WIN32
+#define chunkfile_seek _fseeki64
+#define chunkfile_tell _ftelli64
+typedef long long ChunkFileOffset;
+#else
+#include <sys/types.h>
+#define chunkfile_seek fseeko
+#define chunkfile_tell ftello
+typedef off_t ChunkFileOffset;
+#endif
+
+// octree construction state. triangles are reordered in place so every leaf
+// owns a contiguous range of tris.
+typedef struct {
+    const IndexedMesh* mesh;
+    int max_chunk_triangles;
+    int* tris;
+    int* scratch;
+    ChunkNode* nodes;
+    int num_nodes;
+    int node_capacity;
+    ChunkInfo* chunks;
+    int* chunk_starts;      // first index into tris for each chunk
+    int num_chunks;
+    int chunk_capacity;
+    int max_leaf;
+} ChunkBuilder;
+
+static inline void chunk_vertex(const ChunkBuilder* b, int tri, int corner, double out[3]) {
+    const int index = b->mesh->indices[tri * 3 + corner];
+    out[0] = b->mesh->positions->x[index];
+    out[1] = b->mesh->positions->y[index];
+    out[2] = b->mesh->positions->z[index];
+}
+
+static int builder_push_node(ChunkBuilder* b) {
+    if (b->num_nodes == b->node_capacity) {
+        const int capacity = b->node_capacity ? b->node_capacity * 2 : 64;
+        ChunkNode* nodes = (ChunkNode*)realloc(b->nodes, sizeof(ChunkNode) * capacity);
+        if (nodes == NULL) {
+            fprintf(stderr, "Error allocating memory for chunk nodes\n");
+            return -1;
+        }
+        b->nodes = nodes;
+        b->node_capacity = capacity;
+    }
+    // nodes are written out whole, so clear the tail padding too
+    memset(&b->nodes[b->num_nodes], 0, sizeof(ChunkNode));
+    return b->num_nodes++;
+}
+
+static int builder_push_chunk(ChunkBuilder* b) {
+    if (b->num_chunks == b->chunk_capacity) {
+        const int capacity = b->chunk_capacity ? b->chunk_capacity * 2 : 64;
+        ChunkInfo* chunks = (ChunkInfo*)realloc(b->chunks, sizeof(ChunkInfo) * capacity);
+        int* starts = (int*)realloc(b->chunk_starts, sizeof(int) * capacity);
+        if (chunks != NULL) {
+            b->chunks = chunks;
+        }
+        if (starts != NULL) {
+            b->chunk_starts = starts;
+        }
+        if (chunks == NULL || starts == NULL) {
+            fprintf(stderr, "Error allocating memory for chunk table\n");
+            return -1;
+        }
+        b->chunk_capacity = capacity;
+    }
+    return b->num_chunks++;
+}
+
+// returns node index, -1 if error.
+static int builder_build(ChunkBuilder* b, int start, int count, int depth) {
+    const int node = builder_push_node(b);
+    if (node < 0) {
+        return -1;
+    }
+
+    // bounds of every vertex for culling, centroid bounds for splitting
+    double min[3] = {INFINITY, INFINITY, INFINITY}, max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    double cmin[3] = {INFINITY, INFINITY, INFINITY}, cmax[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (int i = start; i < start + count; i++) {
+        double centroid[3] = {0, 0, 0};
+        for (int corner = 0; corner < 3; corner++) {
+            double v[3];
+            chunk_vertex(b, b->tris[i], corner, v);
+            for (int axis = 0; axis < 3; axis++) {
+                min[axis] = fmin(min[axis], v[axis]);
+                max[axis] = fmax(max[axis], v[axis]);
+                centroid[axis] += v[axis] / 3.0;
+            }
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            cmin[axis] = fmin(cmin[axis], centroid[axis]);
+            cmax[axis] = fmax(cmax[axis], centroid[axis]);
+        }
+    }
+
+    ChunkNode* n = &b->nodes[node];
+    for (int axis = 0; axis < 3; axis++) {
+        n->min[axis] = min[axis];
+        n->max[axis] = max[axis];
+    }
+    for (int child = 0; child < 8; child++) {
+        n->children[child] = -1;
+    }
+    n->chunk = -1;
+
+    // split by centroid octant
+    int bucket_counts[8] = {0};
+    int* octants = b->scratch; // octant per triangle, indexed like tris
+    if (count > b->max_chunk_triangles && depth < CHUNKFILE_MAX_DEPTH) {
+        for (int i = start; i < start + count; i++) {
+            double centroid[3] = {0, 0, 0};
+            for (int corner = 0; corner < 3; corner++) {
+                double v[3];
+                chunk_vertex(b, b->tris[i], corner, v);
+                for (int axis = 0; axis < 3; axis++) {
+                    centroid[axis] += v[axis] / 3.0;
+                }
+            }
+            int octant = 0;
+            for (int axis = 0; axis < 3; axis++) {
+                if (centroid[axis] > (cmin[axis] + cmax[axis]) * 0.5) {
+                    octant |= 1 << axis;
+                }
+            }
+            octants[i] = octant;
+            bucket_counts[octant]++;
+        }
+    }
+
+    int largest_bucket = 0;
+    for (int octant = 0; octant < 8; octant++) {
+        if (bucket_counts[octant] > largest_bucket) {
+            largest_bucket = bucket_counts[octant];
+        }
+    }
+
+    // leaf if small enough, too deep, or the split would not separate anything
+    if (largest_bucket == 0 || largest_bucket == count) {
+        const int chunk = builder_push_chunk(b);
+        if (chunk < 0) {
+            return -1;
+        }
+        ChunkInfo* info = &b->chunks[chunk];
+        info->offset = 0; // filled in when writing
+        info->num_triangles = count;
+        info->reserved = 0;
+        double radius_sq = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            info->center[axis] = (min[axis] + max[axis]) * 0.5;
+            radius_sq += pow((max[axis] - min[axis]) * 0.5, 2);
+        }
+        info->radius = sqrt(radius_sq);
+        b->chunk_starts[chunk] = start;
+        b->nodes[node].chunk = chunk;
+        if (count > b->max_leaf) {
+            b->max_leaf = count;
+        }
+        return node;
+    }
+
+    // stable counting sort of this range by octant
+    int bucket_starts[8];
+    int offset = start;
+    for (int octant = 0; octant < 8; octant++) {
+        bucket_starts[octant] = offset;
+        offset += bucket_counts[octant];
+    }
+    int* sorted = (int*)malloc(sizeof(int) * count);
+    if (sorted == NULL) {
+        fprintf(stderr, "Error allocating memory for octree split\n");
+        return -1;
+    }
+    int fill[8];
+    for (int octant = 0; octant < 8; octant++) {
+        fill[octant] = bucket_starts[octant] - start;
+    }
+    for (int i = start; i < start + count; i++) {
+        sorted[fill[octants[i]]++] = b->tris[i];
+    }
+    memcpy(&b->tris[start], sorted, sizeof(int) * count);
+    free(sorted);
+
+    for (int octant = 0; octant < 8; octant++) {
+        if (bucket_counts[octant] == 0) {
+            continue;
+        }
+        const int child = builder_build(b, bucket_starts[octant], bucket_counts[octant], depth + 1);
+        if (child < 0) {
+            return -1;
+        }
+        b->nodes[node].children[octant] = child; // nodes may have moved
+    }
+    return node;
+}
+
+static int chunkfile_write_payload(FILE* file, const ChunkBuilder* b, double* buffer) {
+    for (int chunk = 0; chunk < b->num_chunks; chunk++) {
+        const int start = b->chunk_starts[chunk];
+        const int count = b->chunks[chunk].num_triangles;
+        const VertexStream* streams[2] = {b->mesh->positions, b->mesh->colors};
+
+        for (int s = 0; s < 2; s++) {
+            for (int axis = 0; axis < 3; axis++) {
+                const double* src = axis == 0 ? streams[s]->x : axis == 1 ? streams[s]->y : streams[s]->z;
+                for (int i = 0; i < count; i++) {
+                    const int tri = b->tris[start + i];
+                    for (int corner = 0; corner < 3; corner++) {
+                        // positions are indexed, colors are per corner
+                        const int index = s == 0 ? b->mesh->indices[tri * 3 + corner] : tri * 3 + corner;
+                        buffer[i * 3 + corner] = src[index];
+                    }
+                }
+                if (fwrite(buffer, sizeof(double), count * 3, file) != (size_t)(count * 3)) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// splits mesh into an octree of chunks holding at most max_chunk_triangles
+// (unless CHUNKFILE_MAX_DEPTH is hit first). returns status code.
+int chunkfile_write(const char* path, const IndexedMesh* mesh, int max_chunk_triangles) {
+    if (mesh == NULL || mesh->num_triangles <= 0 || max_chunk_triangles <= 0) {
+        fprintf(stderr, "Cannot write an empty mesh to a chunk file\n");
+        return 1;
+    }
+
+    ChunkBuilder b = {
+        .mesh = mesh,
+        .max_chunk_triangles = max_chunk_triangles,
+        .tris = (int*)malloc(sizeof(int) * mesh->num_triangles),
+        .scratch = (int*)malloc(sizeof(int) * mesh->num_triangles),
+        .nodes = NULL, .num_nodes = 0, .node_capacity = 0,
+        .chunks = NULL, .chunk_starts = NULL, .num_chunks = 0, .chunk_capacity = 0,
+        .max_leaf = 0
+    };
+
+    int status = 1;
+    double* buffer = NULL;
+    FILE* file = NULL;
+    if (b.tris == NULL || b.scratch == NULL) {
+        fprintf(stderr, "Error allocating memory for chunk builder\n");
+        goto cleanup;
+    }
+    for (int i = 0; i < mesh->num_triangles; i++) {
+        b.tris[i] = i;
+    }
+    if (builder_build(&b, 0, mesh->num_triangles, 0) < 0) {
+        goto cleanup;
+    }
+
+    ChunkFileHeader header = {
+        .magic = {0},
+        .version = CHUNKFILE_VERSION,
+        .num_nodes = b.num_nodes,
+        .num_chunks = b.num_chunks,
+        .max_chunk_triangles = b.max_leaf
+    };
+    memcpy(header.magic, CHUNKFILE_MAGIC, 4);
+
+    long long offset = sizeof(ChunkFileHeader) + sizeof(ChunkNode) * (long long)b.num_nodes
+                     + sizeof(ChunkInfo) * (long long)b.num_chunks;
+    for (int chunk = 0; chunk < b.num_chunks; chunk++) {
+        b.chunks[chunk].offset = offset;
+        offset += sizeof(double) * 18LL * b.chunks[chunk].num_triangles;
+    }
+
+    buffer = (double*)malloc(sizeof(double) * 3 * b.max_leaf);
+    if (buffer == NULL) {
+        fprintf(stderr, "Error allocating memory for chunk payload\n");
+        goto cleanup;
+    }
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening %s for writing\n", path);
+        goto cleanup;
+    }
+    if (fwrite(&header, sizeof(header), 1, file) != 1
+            || fwrite(b.nodes, sizeof(ChunkNode), b.num_nodes, file) != (size_t)b.num_nodes
+            || fwrite(b.chunks, sizeof(ChunkInfo), b.num_chunks, file) != (size_t)b.num_chunks
+            || chunkfile_write_payload(file, &b, buffer)) {
+        fprintf(stderr, "Error writing %s\n", path);
+        goto cleanup;
+    }
+    status = 0;
+
+cleanup:
+    if (file != NULL && fclose(file) != 0 && status == 0) {
+        fprintf(stderr, "Error writing %s\n", path);
+        status = 1;
+    }
+    free(buffer);
+    free(b.tris);
+    free(b.scratch);
+    free(b.nodes);
+    free(b.chunks);
+    free(b.chunk_starts);
+    return status;
+}
+
+// the octree must be a tree as chunkfile_write lays it out: every node but the
+// root has exactly one parent, stored before it, at most CHUNKFILE_MAX_DEPTH
+// levels down. that keeps traversal finite and its recursion shallow.
+// leaves have no children and every chunk belongs to at most one leaf, so a
+// traversal visits each chunk at most once (the pager's tables rely on it).
+// returns 1 if valid.
+static int chunkfile_nodes_valid(const ChunkFileHeader* header, const ChunkNode* nodes) {
+    int* depths = (int*)malloc(sizeof(int) * header->num_nodes);
+    unsigned char* chunk_used = (unsigned char*)calloc(header->num_chunks, 1);
+    if (depths == NULL || chunk_used == NULL) {
+        fprintf(stderr, "Error allocating memory for chunk index check\n");
+        free(depths);
+        free(chunk_used);
+        return 0;
+    }
+    depths[0] = 0;
+    for (int node = 1; node < header->num_nodes; node++) {
+        depths[node] = -1;
+    }
+
+    int valid = 1;
+    for (int node = 0; node < header->num_nodes && valid; node++) {
+        const ChunkNode* n = &nodes[node];
+        if (depths[node] < 0) {
+            fprintf(stderr, "Corrupt chunk file: node %d is unreachable\n", node);
+            valid = 0;
+        } else if (n->chunk < -1 || n->chunk >= header->num_chunks) {
+            fprintf(stderr, "Corrupt chunk file: node %d has chunk %d of %d\n", node, n->chunk, header->num_chunks);
+            valid = 0;
+        } else if (n->chunk >= 0 && chunk_used[n->chunk]) {
+            fprintf(stderr, "Corrupt chunk file: chunk %d belongs to more than one leaf\n", n->chunk);
+            valid = 0;
+        } else if (n->chunk >= 0) {
+            chunk_used[n->chunk] = 1;
+        }
+
+        for (int octant = 0; octant < 8 && valid; octant++) {
+            const int child = n->children[octant];
+            if (child == -1) {
+                continue;
+            }
+            if (n->chunk >= 0) {
+                fprintf(stderr, "Corrupt chunk file: leaf node %d has children\n", node);
+                valid = 0;
+            } else if (child <= node || child >= header->num_nodes || depths[child] >= 0) {
+                fprintf(stderr, "Corrupt chunk file: node %d has child %d of %d\n", node, child, header->num_nodes);
+                valid = 0;
+            } else if (depths[node] == CHUNKFILE_MAX_DEPTH) {
+                fprintf(stderr, "Corrupt chunk file: octree deeper than %d\n", CHUNKFILE_MAX_DEPTH);
+                valid = 0;
+            } else {
+                depths[child] = depths[node] + 1;
+            }
+        }
+    }
+
+    free(depths);
+    free(chunk_used);
+    return valid;
+}
+
+// every chunk holds at most max_chunk_triangles (the largest matches it
+// exactly, the pager sizes slots from it) and its payload lies between the
+// end of the index and the end of the file. returns 1 if valid.
+static int chunkfile_chunks_valid(const ChunkFileHeader* header, const ChunkInfo* chunks,
+                                  long long index_end, long long file_size) {
+    int largest = 0;
+    for (int chunk = 0; chunk < header->num_chunks; chunk++) {
+        const ChunkInfo* info = &chunks[chunk];
+        if (info->num_triangles < 0 || info->num_triangles > header->max_chunk_triangles) {
+            fprintf(stderr, "Corrupt chunk file: chunk %d has %d triangles, max %d\n",
+                    chunk, info->num_triangles, header->max_chunk_triangles);
+            return 0;
+        }
+        const long long payload = sizeof(double) * 18LL * info->num_triangles;
+        if (info->offset < index_end || info->offset > file_size - payload) {
+            fprintf(stderr, "Corrupt chunk file: chunk %d at %lld runs outside the file\n", chunk, info->offset);
+            return 0;
+        }
+        if (info->num_triangles > largest) {
+            largest = info->num_triangles;
+        }
+    }
+    if (largest != header->max_chunk_triangles) {
+        fprintf(stderr, "Corrupt chunk file: largest chunk has %d triangles, header says %d\n",
+                largest, header->max_chunk_triangles);
+        return 0;
+    }
+    return 1;
+}
+
+// reads the header, octree and chunk table. everything is checked against the
+// header and the file size, so a truncated or hostile file is rejected here
+// instead of indexing out of bounds later. make sure to free nodes and chunks.
+// returns status code.
+int chunkfile_read_index(FILE* file, ChunkFileHeader* header, ChunkNode** nodes, ChunkInfo** chunks) {
+    *nodes = NULL;
+    *chunks = NULL;
+    if (chunkfile_seek(file, 0, SEEK_END) != 0) {
+        fprintf(stderr, "Error seeking chunk file\n");
+        return 1;
+    }
+    const long long file_size = chunkfile_tell(file);
+    if (file_size < 0 || chunkfile_seek(file, 0, SEEK_SET) != 0 || fread(header, sizeof(ChunkFileHeader), 1, file) != 1) {
+        fprintf(stderr, "Error reading chunk file header\n");
+        return 1;
+    }
+    if (memcmp(header->magic, CHUNKFILE_MAGIC, 4) != 0 || header->version != CHUNKFILE_VERSION) {
+        fprintf(stderr, "Not a version %d chunk file\n", CHUNKFILE_VERSION);
+        return 1;
+    }
+    const long long index_end = sizeof(ChunkFileHeader) + sizeof(ChunkNode) * (long long)header->num_nodes
+                              + sizeof(ChunkInfo) * (long long)header->num_chunks;
+    if (header->num_nodes <= 0 || header->num_chunks <= 0 || header->max_chunk_triangles <= 0
+            || header->max_chunk_triangles > INT_MAX / 3 || index_end > file_size) {
+        fprintf(stderr, "Corrupt chunk file header\n");
+        return 1;
+    }
+
+    *nodes = (ChunkNode*)malloc(sizeof(ChunkNode) * header->num_nodes);
+    *chunks = (ChunkInfo*)malloc(sizeof(ChunkInfo) * header->num_chunks);
+    if (*nodes == NULL || *chunks == NULL) {
+        fprintf(stderr, "Error allocating memory for chunk index\n");
+    } else if (fread(*nodes, sizeof(ChunkNode), header->num_nodes, file) != (size_t)header->num_nodes
+            || fread(*chunks, sizeof(ChunkInfo), header->num_chunks, file) != (size_t)header->num_chunks) {
+        fprintf(stderr, "Error reading chunk index\n");
+    } else if (chunkfile_nodes_valid(header, *nodes)
+            && chunkfile_chunks_valid(header, *chunks, index_end, file_size)) {
+        return 0;
+    }
+
+    free(*nodes);
+    free(*chunks);
+    *nodes = NULL;
+    *chunks = NULL;
+    return 1;
+}
+
+// out must have room for chunk->num_triangles triangles. its indices are left
+// alone, they are expected to already be 0, 1, 2, ... (a triangle soup).
+// returns status code.
+int chunkfile_read_chunk(FILE* file, const ChunkInfo* chunk, IndexedMesh* out) {
+    const size_t count = (size_t)chunk->num_triangles * 3;
+    if ((ChunkFileOffset)chunk->offset != chunk->offset
+            || chunkfile_seek(file, (ChunkFileOffset)chunk->offset, SEEK_SET) != 0) {
+        fprintf(stderr, "Error seeking to chunk at %lld\n", chunk->offset);
+        return 1;
+    }
+
+    VertexStream* streams[2] = {out->positions, out->colors};
+    for (int s = 0; s < 2; s++) {
+        if (fread(streams[s]->x, sizeof(double), count, file) != count
+                || fread(streams[s]->y, sizeof(double), count, file) != count
+                || fread(streams[s]->z, sizeof(double), count, file) != count) {
+            fprintf(stderr, "Error reading chunk at %lld\n", chunk->offset);
+            return 1;
+        }
+        streams[s]->count = (int)count;
+    }
+    out->num_triangles = chunk->num_triangles;
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef CHUNKFILE_H
+#define CHUNKFILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "geometry.h"
+
+// chunked scene format, native byte order:
+//   ChunkFileHeader
+//   ChunkNode[num_nodes]     octree, node 0 is the root
+//   ChunkInfo[num_chunks]    one per octree leaf
+//   per chunk payload        x, y, z then r, g, b, each 3 * num_triangles doubles
+// chunks are triangle soups, so the payload loads straight into an IndexedMesh.
+
+#define CHUNKFILE_MAGIC "CSCH"
+#define CHUNKFILE_VERSION 1
+#define CHUNKFILE_MAX_DEPTH 16
+
+typedef struct {
+    char magic[4];
+    int version;
+    int num_nodes;
+    int num_chunks;
+    int max_chunk_triangles; // largest chunk in the file, sizes pager slots
+} ChunkFileHeader;
+
+typedef struct {
+    double min[3];
+    double max[3];
+    int children[8];        // -1 if empty
+    int chunk;              // leaf chunk, -1 for interior nodes
+} ChunkNode;
+
+typedef struct {
+    long long offset;       // payload position in the file
+    int num_triangles;
+    int reserved;
+    double center[3];       // bounding sphere
+    double radius;
+} ChunkInfo;
+
+int chunkfile_write(const char* path, const IndexedMesh* mesh, int max_chunk_triangles);
+int chunkfile_read_index(FILE* file, ChunkFileHeader* header, ChunkNode** nodes, ChunkInfo** chunks);
+int chunkfile_read_chunk(FILE* file, const ChunkInfo* chunk, IndexedMesh* out);
+
+#endif // ! CHUNKFILE_H
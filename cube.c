@@ -0,0 +1,85 @@
+#include "cube.h"
+
+// unit cube, vertex i sits at (i & 1, (i & 2) >> 1, (i & 4) >> 2)
+static const int triangle_indices[CUBE_TRIANGLES][3] = {
+    // south
+    {0, 2, 3}, {0, 3, 1},
+    // east
+    {1, 3, 7}, {1, 7, 5},
+    // north
+    {5, 7, 6}, {5, 6, 4},
+    // wes
+    {4, 6, 2}, {4, 2, 0},
+    // top
+    {2, 6, 7}, {2, 7, 3},
+    // bottom
+    {1, 5, 4}, {1, 4, 0}
+};
+static const double rgb_arr[][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}};
+
+// make sure to free after done with mesh.
+// returns null if error.
+IndexedMesh* cube_mesh_new(void) {
+    IndexedMesh* mesh = indexed_mesh_new(CUBE_TRIANGLES, CUBE_VERTICES);
+    if (mesh == NULL) {
+        return NULL;
+    }
+    cube_mesh_set(mesh, 0, 0, 0, 0);
+    return mesh;
+}
+
+// writes cube number `cube` with its min corner at (x, y, z) into a mesh with
+// room for it: vertices from cube * CUBE_VERTICES, triangles from cube * CUBE_TRIANGLES.
+void cube_mesh_set(IndexedMesh* mesh, int cube, double x, double y, double z) {
+    const int first_vertex = cube * CUBE_VERTICES;
+    for (int i = 0; i < CUBE_VERTICES; i++) {
+        vertex_stream_set(mesh->positions, first_vertex + i, x + (i & 1), y + ((i & 2) >> 1), z + ((i & 4) >> 2));
+    }
+    for (int i = 0; i < CUBE_TRIANGLES; i++) {
+        for (int j = 0; j < 3; j++) {
+            const int corner = (cube * CUBE_TRIANGLES + i) * 3 + j;
+            mesh->indices[corner] = first_vertex + triangle_indices[i][j];
+            vertex_stream_set(mesh->colors, corner, rgb_arr[j][0], rgb_arr[j][1], rgb_arr[j][2]);
+        }
+    }
+}
+
+// adds an anchor pushing the cube away from the camera and the node the cube
+// spins under. scene needs room for 2 more nodes.
+// returns the spinning node, -1 if error.
+int cube_scene_add(SceneGraph* scene) {
+    const double anchor_arr[16] = {
+        1, 0, 0, 0,
+        0, 1, 0, 0,
+        0, 0, 1, CUBE_ANCHOR_Z,
+        0, 0, 0, 1
+    };
+    double identity4x4[16];
+    mat4_identity(identity4x4);
+
+    const int anchor = scene_add_node(scene, -1, anchor_arr);
+    if (anchor < 0) {
+        return -1;
+    }
+    return scene_add_node(scene, anchor, identity4x4);
+}
+
+// rotation applied to the cube once per frame.
+void cube_spin_matrix(double rot[16]) {
+    const double c = cos(CUBE_SPIN_ANGLE), s = sin(CUBE_SPIN_ANGLE);
+    const double rot_arr[16] = {
+        c, -s, 0, 0,
+        c*s, c*c, -s, 0,
+        s*s, c*s, c, 0,
+        0, 0, 0, 1
+    };
+    for (int i = 0; i < 16; i++) {
+        rot[i] = rot_arr[i];
+    }
+}
+
+void cube_spin(SceneGraph* scene, int node, const double rot[16]) {
+    double local[16];
+    mat4_mult(local, rot, scene_local(scene, node));
+    scene_set_local(scene, node, local);
+}
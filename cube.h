@@ -0,0 +1,21 @@
+#ifndef CUBE_H
+#define CUBE_H
+
+#include "geometry.h"
+#include "scene.h"
+
+// the spinning unit cube drawn by main. the golden tests build it through the
+// same functions, so the two cannot drift apart.
+
+#define CUBE_VERTICES 8
+#define CUBE_TRIANGLES 12
+#define CUBE_SPIN_ANGLE 0.01  // radians per frame
+#define CUBE_ANCHOR_Z 3.0     // distance from the camera
+
+IndexedMesh* cube_mesh_new(void);
+void cube_mesh_set(IndexedMesh* mesh, int cube, double x, double y, double z);
+int cube_scene_add(SceneGraph* scene);
+void cube_spin_matrix(double rot[16]);
+void cube_spin(SceneGraph* scene, int node, const double rot[16]);
+
+#endif // ! CUBE_H
@@ -0,0 +1,163 @@
+#include "framebuffer.h"
+
+// returns status code. cleanup if fails
+int framebuffer_init(Framebuffer* fb, int width, int height) {
+    fb->surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (fb->surface == NULL) {
+        fprintf(stderr, "Error creating framebuffer surface: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    fb->renderer = SDL_CreateSoftwareRenderer(fb->surface);
+    if (fb->renderer == NULL) {
+        fprintf(stderr, "Error creating framebuffer renderer: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    return 0;
+}
+
+void framebuffer_cleanup(Framebuffer* fb) {
+    if (fb->renderer != NULL) {
+        SDL_DestroyRenderer(fb->renderer);
+    }
+    if (fb->surface != NULL) {
+        SDL_FreeSurface(fb->surface);
+    }
+    fb->renderer = NULL;
+    fb->surface = NULL;
+}
+
+static inline void framebuffer_pixel(const SDL_Surface* surface, int x, int y, Uint8 rgb[3]) {
+    const Uint32* row = (const Uint32*)((const Uint8*)surface->pixels + y * surface->pitch);
+    const Uint32 pixel = row[x];
+    rgb[0] = (Uint8)(pixel >> 16);
+    rgb[1] = (Uint8)(pixel >> 8);
+    rgb[2] = (Uint8)pixel;
+}
+
+// writes a binary (P6) ppm. returns status code.
+int framebuffer_save_ppm(Framebuffer* fb, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening %s for writing\n", path);
+        return 1;
+    }
+
+    SDL_Surface* surface = fb->surface;
+    fprintf(file, "P6\n%d %d\n255\n", surface->w, surface->h);
+
+    SDL_LockSurface(surface);
+    for (int y = 0; y < surface->h; y++) {
+        for (int x = 0; x < surface->w; x++) {
+            Uint8 rgb[3];
+            framebuffer_pixel(surface, x, y, rgb);
+            fwrite(rgb, 1, 3, file);
+        }
+    }
+    SDL_UnlockSurface(surface);
+
+    const int status = ferror(file) ? 1 : 0;
+    fclose(file);
+    if (status) {
+        fprintf(stderr, "Error writing %s\n", path);
+    }
+    return status;
+}
+
+// compares against a binary (P6) ppm written by framebuffer_save_ppm.
+// if the comparison fails and diff_path is not null, a ppm is written there
+// with mismatching pixels in magenta over a dimmed copy of the frame.
+// returns status code, diff is only filled in on success.
+int framebuffer_compare_ppm(Framebuffer* fb, const char* path, FramebufferTolerance tolerance,
+                            FramebufferDiff* diff, const char* diff_path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening %s for reading\n", path);
+        return 1;
+    }
+
+    SDL_Surface* surface = fb->surface;
+    int width, height, max_val;
+    if (fscanf(file, "P6 %d %d %d", &width, &height, &max_val) != 3 || max_val != 255 || fgetc(file) == EOF) {
+        fprintf(stderr, "Error parsing ppm header of %s\n", path);
+        fclose(file);
+        return 1;
+    }
+    if (width != surface->w || height != surface->h) {
+        fprintf(stderr, "Reference size mismatch: %dx%d vs framebuffer %dx%d\n",
+                width, height, surface->w, surface->h);
+        fclose(file);
+        return 1;
+    }
+
+    Uint8* diff_image = (Uint8*)malloc((size_t)width * height * 3);
+    if (diff_image == NULL) {
+        fprintf(stderr, "Error allocating memory for diff image\n");
+        fclose(file);
+        return 1;
+    }
+
+    diff->num_pixels = width * height;
+    diff->diff_pixels = 0;
+    diff->max_channel_diff = 0;
+
+    int status = 0;
+    SDL_LockSurface(surface);
+    for (int y = 0; y < height && !status; y++) {
+        for (int x = 0; x < width; x++) {
+            Uint8 expected[3], actual[3];
+            if (fread(expected, 1, 3, file) != 3) {
+                fprintf(stderr, "Unexpected end of ppm data in %s\n", path);
+                status = 1;
+                break;
+            }
+            framebuffer_pixel(surface, x, y, actual);
+
+            int pixel_diff = 0;
+            for (int c = 0; c < 3; c++) {
+                const int channel_diff = abs((int)expected[c] - (int)actual[c]);
+                if (channel_diff > pixel_diff) {
+                    pixel_diff = channel_diff;
+                }
+            }
+
+            Uint8* out = &diff_image[((size_t)y * width + x) * 3];
+            if (pixel_diff > tolerance.channel) {
+                diff->diff_pixels++;
+                out[0] = 255;
+                out[1] = 0;
+                out[2] = 255;
+            } else {
+                for (int c = 0; c < 3; c++) {
+                    out[c] = actual[c] / 4;
+                }
+            }
+            if (pixel_diff > diff->max_channel_diff) {
+                diff->max_channel_diff = pixel_diff;
+            }
+        }
+    }
+    SDL_UnlockSurface(surface);
+    fclose(file);
+
+    diff->passed = diff->diff_pixels <= tolerance.pixels;
+    if (!status && !diff->passed && diff_path != NULL) {
+        FILE* out = fopen(diff_path, "wb");
+        if (out == NULL) {
+            fprintf(stderr, "Error opening %s for writing\n", diff_path);
+            status = 1;
+        } else {
+            fprintf(out, "P6\n%d %d\n255\n", width, height);
+            fwrite(diff_image, 1, (size_t)width * height * 3, out);
+            if (ferror(out)) {
+                fprintf(stderr, "Error writing %s\n", diff_path);
+                status = 1;
+            }
+            fclose(out);
+        }
+    }
+
+    free(diff_image);
+    return status;
+}
@@ -0,0 +1,36 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// offscreen render target. lets the rasterizer run without a window so
+// frames can be saved and compared against reference images.
+typedef struct {
+    SDL_Surface* surface;
+    SDL_Renderer* renderer;
+} Framebuffer;
+
+// pixels is 0 for pixel-exact comparisons. a budget is only for comparing
+// against images from another renderer or build, where pixels lying exactly on
+// an edge may flip fully on or off, which no channel tolerance absorbs.
+typedef struct {
+    int channel;            // a pixel matches if no channel is off by more than this
+    int pixels;             // mismatching pixels still accepted
+} FramebufferTolerance;
+
+typedef struct {
+    int num_pixels;
+    int diff_pixels;        // pixels with a channel outside of tolerance
+    int max_channel_diff;
+    int passed;             // diff_pixels within the pixel budget
+} FramebufferDiff;
+
+int framebuffer_init(Framebuffer* fb, int width, int height);
+void framebuffer_cleanup(Framebuffer* fb);
+int framebuffer_save_ppm(Framebuffer* fb, const char* path);
+int framebuffer_compare_ppm(Framebuffer* fb, const char* path, FramebufferTolerance tolerance,
+                            FramebufferDiff* diff, const char* diff_path);
+
+#endif // ! FRAMEBUFFER_H
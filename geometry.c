@@ -35,7 +35,7 @@ Mesh* mesh_new(int num_triangles) {
     return mesh;
 }
 
-inline void mesh_set(Mesh* mesh, int index, Triangle* tri) {
+void mesh_set(Mesh* mesh, int index, Triangle* tri) {
     if (mesh == NULL || tri == NULL) {
         fprintf(stderr, "Cannot call mesh_set on a null mesh/triangle\n");
         return;
@@ -48,10 +48,76 @@ inline void mesh_set(Mesh* mesh, int index, Triangle* tri) {
     mesh->tris[index] = *tri;
 }
 
-inline void free_mesh(Mesh* mesh) {
+void free_mesh(Mesh* mesh) {
     free(mesh->tris);
     free(mesh);
 }
 
+// make sure to free after done with stream.
+// returns null if error.
+VertexStream* vertex_stream_new(int count) {
+    VertexStream* stream = (VertexStream*)malloc(sizeof(VertexStream));
+    if (stream == NULL) {
+        fprintf(stderr, "Error allocating memory for vertex stream\n");
+        return NULL;
+    }
+
+    stream->count = count;
+    stream->x = (double*)malloc(sizeof(double) * count);
+    stream->y = (double*)malloc(sizeof(double) * count);
+    stream->z = (double*)malloc(sizeof(double) * count);
+    if (stream->x == NULL || stream->y == NULL || stream->z == NULL) {
+        fprintf(stderr, "Error allocating memory for vertex stream data\n");
+        free_vertex_stream(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+void free_vertex_stream(VertexStream* stream) {
+    if (stream == NULL) {
+        return;
+    }
+
+    free(stream->x);
+    free(stream->y);
+    free(stream->z);
+    free(stream);
+}
+
+// make sure to free after done with mesh.
+// returns null if error.
+IndexedMesh* indexed_mesh_new(int num_triangles, int num_vertices) {
+    IndexedMesh* mesh = (IndexedMesh*)malloc(sizeof(IndexedMesh));
+    if (mesh == NULL) {
+        fprintf(stderr, "Error allocating memory for indexed mesh\n");
+        return NULL;
+    }
+
+    mesh->num_triangles = num_triangles;
+    mesh->indices = (int*)malloc(sizeof(int) * 3 * num_triangles);
+    mesh->positions = vertex_stream_new(num_vertices);
+    mesh->colors = vertex_stream_new(3 * num_triangles);
+    if (mesh->indices == NULL || mesh->positions == NULL || mesh->colors == NULL) {
+        fprintf(stderr, "Error allocating memory for indexed mesh data\n");
+        free_indexed_mesh(mesh);
+        return NULL;
+    }
+
+    return mesh;
+}
+
+void free_indexed_mesh(IndexedMesh* mesh) {
+    if (mesh == NULL) {
+        return;
+    }
+
+    free(mesh->indices);
+    free_vertex_stream(mesh->positions);
+    free_vertex_stream(mesh->colors);
+    free(mesh);
+}
+
 // TODO: add color to triangle struct
 // create a triangle normal function?
@@ -15,10 +15,38 @@ typedef struct {
     Triangle* tris;
 } Mesh;
 
+// structure of arrays so batch kernels can stream each coordinate.
+typedef struct {
+    int count;
+    double* x;
+    double* y;
+    double* z;
+} VertexStream;
+
+// triangles index into a shared vertex stream so each vertex is only
+// transformed once. colors are per triangle corner (3 per triangle).
+typedef struct {
+    int num_triangles;
+    int* indices;
+    VertexStream* positions;
+    VertexStream* colors;
+} IndexedMesh;
+
 Triangle* triangle_new(Matrix* vertices[], Matrix* colors[]);
 
 Mesh* mesh_new(int num_triangles);
-inline void mesh_set(Mesh* mesh, int index, Triangle* tri);
-inline void free_mesh(Mesh* mesh);
+void mesh_set(Mesh* mesh, int index, Triangle* tri);
+void free_mesh(Mesh* mesh);
+
+VertexStream* vertex_stream_new(int count);
+void free_vertex_stream(VertexStream* stream);
+IndexedMesh* indexed_mesh_new(int num_triangles, int num_vertices);
+void free_indexed_mesh(IndexedMesh* mesh);
+
+static inline void vertex_stream_set(VertexStream* stream, int index, double x, double y, double z) {
+    stream->x[index] = x;
+    stream->y[index] = y;
+    stream->z[index] = z;
+}
 
 #endif // ! GEOMETRY_H
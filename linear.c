@@ -177,3 +177,44 @@ void matrix_print(const Matrix* mat, const char* name) {
         printf("]\n");
     }
 }
+
+void mat4_identity(double out[16]) {
+    for (int i = 0; i < 16; i++) {
+        out[i] = (i % 5 == 0) ? 1.0 : 0.0;
+    }
+}
+
+// copies a 3x3 or 4x4 matrix into the upper left of out, rest is identity.
+void mat4_from_matrix(double out[16], const Matrix* mat) {
+    mat4_identity(out);
+    if (!matrix_is_valid(mat, 0, 0)) {
+        return;
+    }
+    if (mat->rows > 4 || mat->cols > 4) {
+        fprintf(stderr, "Matrix too large for 4x4: %dx%d\n", mat->rows, mat->cols);
+        return;
+    }
+
+    for (int row = 0; row < mat->rows; row++) {
+        for (int col = 0; col < mat->cols; col++) {
+            out[row * 4 + col] = mat->data[row * mat->cols + col];
+        }
+    }
+}
+
+// out may alias left or right.
+void mat4_mult(double out[16], const double left[16], const double right[16]) {
+    double result[16];
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            double element = 0;
+            for (int pair = 0; pair < 4; pair++) {
+                element += left[row * 4 + pair] * right[pair * 4 + col];
+            }
+            result[row * 4 + col] = element;
+        }
+    }
+    for (int i = 0; i < 16; i++) {
+        out[i] = result[i];
+    }
+}
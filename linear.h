@@ -57,4 +57,9 @@ double dot_mult(const Matrix* left, const Matrix* right);
 
 void matrix_print(const Matrix* mat, const char* name);
 
+// fixed-size 4x4 helpers, row-major double[16]. no allocation.
+void mat4_identity(double out[16]);
+void mat4_from_matrix(double out[16], const Matrix* mat);
+void mat4_mult(double out[16], const double left[16], const double right[16]);
+
 #endif // ! LINEAR_H
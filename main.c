@@ -2,84 +2,111 @@
 #include "linear.h"
 #include "video.h"
 #include "render.h"
+#include "scene.h"
+#include "framebuffer.h"
+#include "transform.h"
+#include "chunkfile.h"
+#include "pager.h"
+#include "cube.h"
+#include <limits.h>
+#include <string.h>
 
-int main() {
+#define PACK_CHUNK_TRIANGLES 4096
+#define STREAM_BUDGET_MB 64
+#define STREAM_SPEED 0.05
+#define COMPARE_DIFF_PATH "compare_diff.ppm"
 
-    // init matrices
-    Matrix* rot_matrix = matrix_new(3, 3);
-    const double rot_arr[] = {
-    cos(0.01), -sin(0.01), 0,
-        cos(0.01)*sin(0.01), cos(0.01)*cos(0.01), -sin(0.01),
-        sin(0.01)*sin(0.01), cos(0.01)*sin(0.01), cos(0.01)
-    };
-    matrix_init(rot_matrix, rot_arr);
+// returns status code.
+typedef int (*DrawFrame)(SDL_Renderer* renderer, void* data);
 
+// everything needed to draw a frame of the spinning cube.
+typedef struct {
+    IndexedMesh* mesh;
+    VertexStream* view;     // scratch for draw_indexed_mesh
+    VertexStream* screen;
+    SceneGraph* scene;
+    int node;
+    double rot[16];         // applied to node once per frame
+    Matrix* proj_matrix;
+    Matrix* camera_pos;
+} CubeScene;
 
-    Matrix* model_matrix = matrix_new(3, 3);
-    const double identity3x3[] = {
-        1, 0, 0,
-        0, 1, 0,
-        0, 0, 1,
-    };
-    matrix_init(model_matrix, identity3x3);
+// a chunk file paged in around a camera flying down +z.
+typedef struct {
+    Pager* pager;
+    VertexStream* view;     // scratch sized for the largest chunk
+    VertexStream* screen;
+    const Matrix* proj_matrix;
+    Matrix* camera_pos;     // world space
+    Matrix* eye;            // camera in camera space, always the origin
+} StreamScene;
 
+static int draw_cube(SDL_Renderer* renderer, CubeScene* cube) {
+    scene_update(cube->scene);
+    return draw_indexed_mesh(renderer, cube->mesh, scene_world(cube->scene, cube->node),
+                             cube->proj_matrix, cube->camera_pos, cube->view, cube->screen);
+}
 
-    // make projection matrix
-    const double f = 1/tan(FOV_DEG * M_PI / 360.0);
-    const double q = ZFAR / (ZFAR - ZNEAR);
-    Matrix* proj_matrix = matrix_new(3, 4);
-    const double proj_arr[] = {
-        ASPECT_RATIO * f, 0, 0, 0,
-                       0, f, 0, 0,
-                       0, 0, q, -ZNEAR * q
-    };
-    matrix_init(proj_matrix, proj_arr);
-
-    Matrix* camera_pos = matrix_new(3, 1); // malloc auto initializes to 0
-
-    // make vertices
-    Matrix* coord_vecs[8];
-    for (int i = 0; i < 8; i++) {
-        const double coord[] = {i & 1, (i & 2) >> 1, (i & 4) >> 2};
-        coord_vecs[i] = matrix_new(3, 1);
-        matrix_init(coord_vecs[i], coord);
-    }
-
-    // make mesh
-    const int triangle_indices[][3] = {
-        // south
-        {0, 2, 3}, {0, 3, 1},
-        // east
-        {1, 3, 7}, {1, 7, 5},
-        // north
-        {5, 7, 6}, {5, 6, 4},
-        // wes
-        {4, 6, 2}, {4, 2, 0},
-        // top
-        {2, 6, 7}, {2, 7, 3},
-        // bottom
-        {1, 5, 4}, {1, 4, 0}
+static int draw_cube_frame(SDL_Renderer* renderer, void* data) {
+    CubeScene* cube = (CubeScene*)data;
+    cube_spin(cube->scene, cube->node, cube->rot);
+    return draw_cube(renderer, cube);
+}
+
+static int draw_stream_frame(SDL_Renderer* renderer, void* data) {
+    StreamScene* stream = (StreamScene*)data;
+    matrix_set(stream->camera_pos, 2, 0, matrix_get(stream->camera_pos, 2, 0) + STREAM_SPEED);
+
+    double world[16];
+    mat4_identity(world);
+    for (int row = 0; row < 3; row++) {
+        world[row * 4 + 3] = -matrix_get(stream->camera_pos, row, 0);
+    }
+
+    const int num_drawable = pager_update(stream->pager, stream->camera_pos);
+    for (int i = 0; i < num_drawable; i++) {
+        if (draw_indexed_mesh(renderer, pager_drawable(stream->pager, i), world,
+                              stream->proj_matrix, stream->eye, stream->view, stream->screen)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// draws frames back to back into an offscreen framebuffer and reports timing.
+// this is also the training run for profile-guided builds.
+// returns status code.
+static int run_bench(int frames, DrawFrame draw_frame, void* data) {
+    Framebuffer fb = {
+        .surface = NULL,
+        .renderer = NULL
     };
-    
-    Matrix* rgb[] = {matrix_new(3, 1), matrix_new(3, 1), matrix_new(3, 1)};
-    const double rgb_arr[][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}};
-    for (int i = 0; i < 3; i++) {
-        matrix_init(rgb[i], rgb_arr[i]);
-    }
-
-    Mesh* cube_mesh = mesh_new(12);
-    for (int i = 0; i < cube_mesh->num_triangles; i++) {
-        Matrix* vertices[3];
-        for (int j = 0; j < 3; j++) {
-            vertices[j] = coord_vecs[triangle_indices[i][j]];
+    if (framebuffer_init(&fb, SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        framebuffer_cleanup(&fb);
+        return 1;
+    }
+
+    SDL_SetRenderDrawColor(fb.renderer, 0, 0, 0, 255);
+    const Uint64 start = SDL_GetPerformanceCounter();
+    for (int frame = 0; frame < frames; frame++) {
+        SDL_RenderClear(fb.renderer);
+        if (draw_frame(fb.renderer, data)) {
+            framebuffer_cleanup(&fb);
+            return 1;
         }
-        //Triangle* tri = triangle_new(vertices, (Matrix*[]){rgb[2], rgb[2], rgb[2]});
-        Triangle* tri = triangle_new(vertices, rgb);
-        mesh_set(cube_mesh, i, tri);
-        free(tri); // triangle gets copied so must be freed
+        SDL_RenderPresent(fb.renderer);
     }
+    const double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
 
+    printf("bench: %d frames in %.3f ms, %.3f ms/frame (%s transform)\n",
+           frames, ms, frames > 0 ? ms / frames : 0.0, transform_kernel_name());
 
+    framebuffer_cleanup(&fb);
+    return 0;
+}
+
+// returns status code.
+static int run_window(DrawFrame draw_frame, void* data) {
     VideoHandler handler = {
         .window = NULL,
         .renderer = NULL
@@ -114,86 +141,198 @@ int main() {
         }
         SDL_RenderClear(handler.renderer);
         // draw
-        
-        Matrix* new_model = matrix_mult(rot_matrix, model_matrix);
-        free_matrix(model_matrix);
-        model_matrix = new_model;
-
-        for (int i = 0; i < cube_mesh->num_triangles; i++) {
-            Matrix* rotated_verts[3];
-            for (int j = 0; j < 3; j++) {
-                rotated_verts[j] = matrix_mult(model_matrix, cube_mesh->tris[i].vertices[j]);
-                matrix_set(rotated_verts[j], 2, 0, matrix_get(rotated_verts[j], 2, 0) + 3.0);
-            }
-
-            Matrix* edge_a = matrix_subtract(rotated_verts[0], rotated_verts[1]);
-            Matrix* edge_b = matrix_subtract(rotated_verts[2], rotated_verts[1]);
-            Matrix* cross_prod = cross_mult(edge_a, edge_b);
-
-            Matrix* camera_to_point = matrix_subtract(rotated_verts[0], camera_pos);
-            if (dot_mult(cross_prod, camera_to_point) <= 0.0) {
-                free_matrices(rotated_verts, 3);
-                free_matrices((Matrix*[]) {edge_a, edge_b, cross_prod, camera_to_point}, 4);
-                continue;
-            }
 
-            Matrix* light_vec = matrix_new(3, 1);
-            const double light_arr[] = {0, 0, 1};
-            matrix_init(light_vec, light_arr);
-            matrix_normalize(light_vec);
-            matrix_normalize(cross_prod);
-            
-            const double light_factor = dot_mult(cross_prod, light_vec);
-            
-            Matrix* proj_results[3];
-            for (int j = 0; j < 3; j++) {
-                Matrix* homog = matrix_new(4, 1);
-                matrix_set(homog, 0, 0, matrix_get(rotated_verts[j], 0, 0));
-                matrix_set(homog, 1, 0, matrix_get(rotated_verts[j], 1, 0));
-                matrix_set(homog, 2, 0, matrix_get(rotated_verts[j], 2, 0));
-                matrix_set(homog, 3, 0, 1);
-
-
-                const double z = matrix_get(homog, 2, 0);
-                proj_results[j] = matrix_mult(proj_matrix, homog);
-                if (z != 0) {
-                    matrix_set(proj_results[j], 0, 0, matrix_get(proj_results[j], 0, 0) / z);
-                    matrix_set(proj_results[j], 1, 0, matrix_get(proj_results[j], 1, 0) / z);
-                    matrix_set(proj_results[j], 2, 0, matrix_get(proj_results[j], 2, 0) / z);
-                }
-
-                matrix_set(proj_results[j], 0, 0, (matrix_get(proj_results[j], 0, 0) + 1) * 0.5 * SCREEN_WIDTH);
-                matrix_set(proj_results[j], 1, 0, (matrix_get(proj_results[j], 1, 0) + 1) * 0.5 * SCREEN_HEIGHT);
-
-                free_matrix(homog);
-            }
-            /* SDL_RenderDrawLine(handler.renderer, matrix_get(proj_results[0], 0, 0), matrix_get(proj_results[0], 1, 0),
-                               matrix_get(proj_results[1], 0, 0), matrix_get(proj_results[1], 1, 0));
-            SDL_RenderDrawLine(handler.renderer, matrix_get(proj_results[1], 0, 0), matrix_get(proj_results[1], 1, 0),
-                               matrix_get(proj_results[2], 0, 0), matrix_get(proj_results[2], 1, 0));
-            SDL_RenderDrawLine(handler.renderer, matrix_get(proj_results[2], 0, 0), matrix_get(proj_results[2], 1, 0),
-                               matrix_get(proj_results[0], 0, 0), matrix_get(proj_results[0], 1, 0));
-            */
-
-            Triangle* proj_tri = triangle_new(proj_results, cube_mesh->tris[i].colors);
-            draw_triangle(handler.renderer, proj_tri, light_factor);
-            free(proj_tri);
-
-            free_matrices(proj_results, 3);
-            free_matrices(rotated_verts, 3);
-            free_matrices((Matrix*[]) {edge_a, edge_b, cross_prod, camera_to_point, light_vec}, 5);
+        if (draw_frame(handler.renderer, data)) {
+            video_cleanup(&handler);
+            return 1;
         }
         SDL_RenderPresent(handler.renderer);
         SDL_Delay(16);
     }
-
-    free_mesh(cube_mesh);
-    free_matrices(coord_vecs, 8);
-    free_matrices(rgb, 3);
-    free_matrix(rot_matrix);
-    free_matrix(proj_matrix);
-    free_matrix(camera_pos);
     video_cleanup(&handler);
     return 0;
 }
+
+// writes an n*n*n grid of cubes in front of the camera as a chunk file.
+// returns status code.
+static int pack_grid(const char* path, int n) {
+    // 36 ints and doubles per cube (12 triangles, 3 corners), all int indexed
+    if (n <= 0 || (long long)n * n * n > INT_MAX / (3 * CUBE_TRIANGLES)) {
+        fprintf(stderr, "Grid size must be between 1 and %d, got %d\n", (int)cbrt(INT_MAX / (3 * CUBE_TRIANGLES)), n);
+        return 1;
+    }
+
+    const int num_cubes = n * n * n;
+
+    IndexedMesh* grid = indexed_mesh_new(CUBE_TRIANGLES * num_cubes, CUBE_VERTICES * num_cubes);
+    if (grid == NULL) {
+        return 1;
+    }
+    for (int c = 0; c < num_cubes; c++) {
+        const double x = (c % n - n / 2) * 3.0;
+        const double y = ((c / n) % n - n / 2) * 3.0;
+        const double z = (c / (n * n)) * 3.0 + 5.0;
+        cube_mesh_set(grid, c, x, y, z);
+    }
+
+    const int status = chunkfile_write(path, grid, PACK_CHUNK_TRIANGLES);
+    if (!status) {
+        printf("%s: %d triangles\n", path, grid->num_triangles);
+    }
+    free_indexed_mesh(grid);
+    return status;
+}
+
+// pages a chunk file in while flying through it, keeping at most budget_mb of
+// chunks resident. with frames it runs as a headless bench, otherwise in a
+// window. returns status code.
+static int run_stream(const char* path, int frames, int budget_mb, const Matrix* proj_matrix) {
+    StreamScene stream = {
+        .pager = pager_open(path, (size_t)budget_mb * 1024 * 1024),
+        .view = NULL,
+        .screen = NULL,
+        .proj_matrix = proj_matrix,
+        .camera_pos = matrix_new(3, 1),
+        .eye = matrix_new(3, 1)
+    };
+
+    int status = 1;
+    if (stream.pager != NULL && stream.camera_pos != NULL && stream.eye != NULL) {
+        const double origin[] = {0, 0, 0};
+        matrix_init(stream.camera_pos, origin);
+        matrix_init(stream.eye, origin);
+
+        const int max_vertices = 3 * stream.pager->header.max_chunk_triangles;
+        stream.view = vertex_stream_new(max_vertices);
+        stream.screen = vertex_stream_new(max_vertices);
+        if (stream.view != NULL && stream.screen != NULL) {
+            printf("%s: %d chunks, %d resident slots\n", path, stream.pager->header.num_chunks,
+                   stream.pager->num_slots);
+            status = frames > 0 ? run_bench(frames, draw_stream_frame, &stream)
+                                : run_window(draw_stream_frame, &stream);
+            printf("%s: %u loads queued, %u evictions\n", path, stream.pager->num_loads, stream.pager->num_evictions);
+        }
+    }
+
+    pager_close(stream.pager);
+    free_vertex_stream(stream.view);
+    free_vertex_stream(stream.screen);
+    free_matrix(stream.camera_pos);
+    free_matrix(stream.eye);
+    return status;
+}
+
+// command line modes:
+//   --render <frames> <out.ppm>
+//   --compare <frames> <reference.ppm> <tolerance> [pixel budget]
+//   --bench <frames>
+//   --pack <out.chunks> <grid size>
+//   --stream <scene.chunks> [frames] [budget MB]   (windowed without frames or with 0)
+// render/compare draw one frame after a fixed number of rotation steps.
+// returns status code, compare fails if more pixels than the budget (default 0)
+// are outside tolerance.
+static int run_mode(int argc, char* argv[], CubeScene* cube) {
+    if (argc == 3 && strcmp(argv[1], "--bench") == 0) {
+        return run_bench(atoi(argv[2]), draw_cube_frame, cube);
+    }
+    if (argc == 4 && strcmp(argv[1], "--pack") == 0) {
+        return pack_grid(argv[2], atoi(argv[3]));
+    }
+    if (argc >= 3 && argc <= 5 && strcmp(argv[1], "--stream") == 0) {
+        return run_stream(argv[2], argc >= 4 ? atoi(argv[3]) : 0, argc == 5 ? atoi(argv[4]) : STREAM_BUDGET_MB,
+                          cube->proj_matrix);
+    }
+
+    const int compare = (argc == 5 || argc == 6) && strcmp(argv[1], "--compare") == 0;
+    if (!compare && !(argc == 4 && strcmp(argv[1], "--render") == 0)) {
+        fprintf(stderr, "Usage: %s [--render <frames> <out.ppm>"
+                        " | --compare <frames> <reference.ppm> <tolerance> [pixel budget]"
+                        " | --bench <frames> | --pack <out.chunks> <grid size> | --stream <scene.chunks> [frames] [budget MB]]\n",
+                argv[0]);
+        return 1;
+    }
+
+    const int frames = atoi(argv[2]);
+    for (int frame = 0; frame < frames; frame++) {
+        cube_spin(cube->scene, cube->node, cube->rot);
+    }
+
+    Framebuffer fb = {
+        .surface = NULL,
+        .renderer = NULL
+    };
+    if (framebuffer_init(&fb, SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        framebuffer_cleanup(&fb);
+        return 1;
+    }
+
+    SDL_SetRenderDrawColor(fb.renderer, 0, 0, 0, 255);
+    SDL_RenderClear(fb.renderer);
+    const Uint64 start = SDL_GetPerformanceCounter();
+    if (draw_cube(fb.renderer, cube)) {
+        framebuffer_cleanup(&fb);
+        return 1;
+    }
+    SDL_RenderPresent(fb.renderer); // flushes queued draws into the surface
+    const double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    int status;
+    if (compare) {
+        const FramebufferTolerance tolerance = {
+            .channel = atoi(argv[4]),
+            .pixels = argc == 6 ? atoi(argv[5]) : 0
+        };
+        FramebufferDiff diff;
+        status = framebuffer_compare_ppm(&fb, argv[3], tolerance, &diff, COMPARE_DIFF_PATH);
+        if (!status) {
+            printf("%s: %d/%d pixels differ (max channel diff %d, budget %d), render %.3f ms\n",
+                   argv[3], diff.diff_pixels, diff.num_pixels, diff.max_channel_diff, tolerance.pixels, ms);
+            if (!diff.passed) {
+                printf("%s: FAILED, diff written to %s\n", argv[3], COMPARE_DIFF_PATH);
+            }
+            status = !diff.passed;
+        }
+    } else {
+        status = framebuffer_save_ppm(&fb, argv[3]);
+        printf("%s: render %.3f ms\n", argv[3], ms);
+    }
+
+    framebuffer_cleanup(&fb);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    CubeScene cube;
+
+    cube_spin_matrix(cube.rot);
+    cube.scene = scene_new(2);
+    cube.node = cube_scene_add(cube.scene);
+    cube.proj_matrix = transform_projection_new();
+
+    cube.camera_pos = matrix_new(3, 1);
+    const double origin[] = {0, 0, 0};
+    matrix_init(cube.camera_pos, origin); // malloc does not zero, references need it deterministic
+
+    cube.mesh = cube_mesh_new();
+    cube.view = vertex_stream_new(CUBE_VERTICES);
+    cube.screen = vertex_stream_new(CUBE_VERTICES);
+
+    int status = 1;
+    if (cube.scene == NULL || cube.node < 0 || cube.proj_matrix == NULL || cube.camera_pos == NULL
+            || cube.mesh == NULL || cube.view == NULL || cube.screen == NULL) {
+        fprintf(stderr, "Error setting up the cube scene\n");
+    } else if (argc > 1) {
+        status = run_mode(argc, argv, &cube);
+    } else {
+        status = run_window(draw_cube_frame, &cube);
+    }
+
+    free_indexed_mesh(cube.mesh);
+    free_vertex_stream(cube.view);
+    free_vertex_stream(cube.screen);
+    free_scene(cube.scene);
+    free_matrix(cube.proj_matrix);
+    free_matrix(cube.camera_pos);
+    return status;
+}
 // TODO: add lighting
@@ -0,0 +1,342 @@
+#include "pager.h"
+#include "video.h"
+#include <string.h>
+
+// loader thread. pops slots off the queue and fills them from the file.
+// the lock is never held during i/o.
+static int pager_loader(void* data) {
+    Pager* pager = (Pager*)data;
+
+    SDL_LockMutex(pager->lock);
+    while (1) {
+        while (pager->running && pager->queue_count == 0) {
+            SDL_CondWait(pager->wake, pager->lock);
+        }
+        if (!pager->running) {
+            break;
+        }
+
+        PagerSlot* slot = &pager->slots[pager->queue[pager->queue_head]];
+        pager->queue_head = (pager->queue_head + 1) % pager->num_slots;
+        pager->queue_count--;
+        const ChunkInfo* chunk = &pager->chunks[slot->chunk];
+        SDL_UnlockMutex(pager->lock);
+
+        if (chunkfile_read_chunk(pager->file, chunk, slot->mesh)) {
+            slot->mesh->num_triangles = 0; // drawn as empty rather than retried every frame
+        }
+
+        SDL_LockMutex(pager->lock);
+        slot->state = SLOT_READY;
+    }
+    SDL_UnlockMutex(pager->lock);
+    return 0;
+}
+
+// memory held by one resident slot: indices plus positions and colors.
+size_t pager_slot_bytes(int max_chunk_triangles) {
+    return sizeof(int) * 3 * (size_t)max_chunk_triangles + sizeof(double) * 18 * (size_t)max_chunk_triangles;
+}
+
+// make sure to close after done with pager.
+// budget_bytes caps the memory used by resident chunks (at least one slot).
+// returns null if error.
+Pager* pager_open(const char* path, size_t budget_bytes) {
+    Pager* pager = (Pager*)calloc(1, sizeof(Pager));
+    if (pager == NULL) {
+        fprintf(stderr, "Error allocating memory for pager\n");
+        return NULL;
+    }
+
+    pager->file = fopen(path, "rb");
+    if (pager->file == NULL) {
+        fprintf(stderr, "Error opening %s for reading\n", path);
+        pager_close(pager);
+        return NULL;
+    }
+    if (chunkfile_read_index(pager->file, &pager->header, &pager->nodes, &pager->chunks)) {
+        pager_close(pager);
+        return NULL;
+    }
+
+    const int max_tris = pager->header.max_chunk_triangles;
+    size_t num_slots = budget_bytes / pager_slot_bytes(max_tris);
+    if (num_slots < 1) {
+        num_slots = 1;
+    }
+    if (num_slots > (size_t)pager->header.num_chunks) {
+        num_slots = pager->header.num_chunks;
+    }
+    pager->num_slots = (int)num_slots;
+
+    pager->chunk_slots = (int*)malloc(sizeof(int) * pager->header.num_chunks);
+    pager->chunk_ranks = (int*)malloc(sizeof(int) * pager->header.num_chunks);
+    pager->visible = (PagerVisible*)malloc(sizeof(PagerVisible) * pager->header.num_chunks);
+    pager->slots = (PagerSlot*)calloc(pager->num_slots, sizeof(PagerSlot));
+    pager->queue = (int*)malloc(sizeof(int) * pager->num_slots);
+    pager->pending = (int*)malloc(sizeof(int) * pager->num_slots);
+    pager->drawable = (int*)malloc(sizeof(int) * pager->num_slots);
+    if (pager->chunk_slots == NULL || pager->chunk_ranks == NULL || pager->visible == NULL
+            || pager->slots == NULL || pager->queue == NULL || pager->pending == NULL || pager->drawable == NULL) {
+        fprintf(stderr, "Error allocating memory for pager tables\n");
+        pager_close(pager);
+        return NULL;
+    }
+    for (int chunk = 0; chunk < pager->header.num_chunks; chunk++) {
+        pager->chunk_slots[chunk] = -1;
+        pager->chunk_ranks[chunk] = -1;
+    }
+
+    // every slot is sized for the largest chunk up front, so paging never allocates
+    for (int i = 0; i < pager->num_slots; i++) {
+        PagerSlot* slot = &pager->slots[i];
+        slot->chunk = -1;
+        slot->state = SLOT_FREE;
+        slot->mesh = indexed_mesh_new(max_tris, 3 * max_tris);
+        if (slot->mesh == NULL) {
+            pager_close(pager);
+            return NULL;
+        }
+        for (int index = 0; index < 3 * max_tris; index++) {
+            slot->mesh->indices[index] = index;
+        }
+    }
+
+    pager->lock = SDL_CreateMutex();
+    pager->wake = SDL_CreateCond();
+    if (pager->lock == NULL || pager->wake == NULL) {
+        fprintf(stderr, "Error creating pager lock: %s\n", SDL_GetError());
+        pager_close(pager);
+        return NULL;
+    }
+
+    pager->running = 1;
+    pager->thread = SDL_CreateThread(pager_loader, "pager", pager);
+    if (pager->thread == NULL) {
+        fprintf(stderr, "Error creating pager thread: %s\n", SDL_GetError());
+        pager->running = 0;
+        pager_close(pager);
+        return NULL;
+    }
+
+    return pager;
+}
+
+// bounding sphere against the view frustum. the camera looks down +z,
+// matching the projection matrix built in main.
+static inline int pager_sphere_visible(const double center[3], double radius, const Matrix* camera_pos,
+                                       double* distance) {
+    const double x = center[0] - matrix_get(camera_pos, 0, 0);
+    const double y = center[1] - matrix_get(camera_pos, 1, 0);
+    const double z = center[2] - matrix_get(camera_pos, 2, 0);
+
+    if (z + radius < ZNEAR || z - radius > ZFAR) {
+        return 0;
+    }
+
+    // side planes through the eye: |x| <= z * tan(fov / 2) / aspect, |y| <= z * tan(fov / 2)
+    const double ky = tan(FOV_DEG * M_PI / 360.0);
+    const double kx = ky / ASPECT_RATIO;
+    if ((fabs(x) - z * kx) / sqrt(1 + kx * kx) > radius || (fabs(y) - z * ky) / sqrt(1 + ky * ky) > radius) {
+        return 0;
+    }
+
+    *distance = fmax(sqrt(x * x + y * y + z * z) - radius, 0.0);
+    return 1;
+}
+
+static void pager_collect(Pager* pager, int node, const Matrix* camera_pos) {
+    const ChunkNode* n = &pager->nodes[node];
+    double center[3], radius_sq = 0, distance;
+    for (int axis = 0; axis < 3; axis++) {
+        center[axis] = (n->min[axis] + n->max[axis]) * 0.5;
+        radius_sq += pow((n->max[axis] - n->min[axis]) * 0.5, 2);
+    }
+    if (!pager_sphere_visible(center, sqrt(radius_sq), camera_pos, &distance)) {
+        return;
+    }
+
+    if (n->chunk >= 0) {
+        // chunkfile_read_index guarantees one leaf per chunk, this is a backstop
+        if (pager->num_visible == pager->header.num_chunks) {
+            return;
+        }
+        const ChunkInfo* chunk = &pager->chunks[n->chunk];
+        if (pager_sphere_visible(chunk->center, chunk->radius, camera_pos, &distance)) {
+            pager->visible[pager->num_visible].distance = distance;
+            pager->visible[pager->num_visible].chunk = n->chunk;
+            pager->num_visible++;
+        }
+        return;
+    }
+
+    for (int child = 0; child < 8; child++) {
+        if (n->children[child] >= 0) {
+            pager_collect(pager, n->children[child], camera_pos);
+        }
+    }
+}
+
+static int pager_compare_visible(const void* left, const void* right) {
+    const double a = ((const PagerVisible*)left)->distance;
+    const double b = ((const PagerVisible*)right)->distance;
+    return (a > b) - (a < b);
+}
+
+// free slot first, then the least recently used ready slot not needed this frame.
+// returns slot index, -1 if every slot is busy.
+static int pager_find_slot(const Pager* pager) {
+    int lru = -1;
+    for (int i = 0; i < pager->num_slots; i++) {
+        const PagerSlot* slot = &pager->slots[i];
+        if (slot->state == SLOT_FREE) {
+            return i;
+        }
+        if (slot->state == SLOT_READY && slot->last_used != pager->frame
+                && (lru < 0 || slot->last_used < pager->slots[lru].last_used)) {
+            lru = i;
+        }
+    }
+    return lru;
+}
+
+// rebuilds the load queue from this frame's visible list: loads for chunks
+// that left the view are dropped (their slots go back to the pool) and the
+// rest are sorted nearest first. the slot the loader is reading is not in
+// the queue, so it is never touched. call with the lock held.
+static void pager_requeue(Pager* pager) {
+    int count = 0;
+    for (int i = 0; i < pager->queue_count; i++) {
+        const int index = pager->queue[(pager->queue_head + i) % pager->num_slots];
+        PagerSlot* slot = &pager->slots[index];
+        const int rank = pager->chunk_ranks[slot->chunk];
+        if (rank < 0) {
+            pager->chunk_slots[slot->chunk] = -1;
+            slot->chunk = -1;
+            slot->state = SLOT_FREE;
+            continue;
+        }
+
+        // insertion sort, the queue never holds more than num_slots
+        int j = count++;
+        while (j > 0 && pager->chunk_ranks[pager->slots[pager->pending[j - 1]].chunk] > rank) {
+            pager->pending[j] = pager->pending[j - 1];
+            j--;
+        }
+        pager->pending[j] = index;
+    }
+
+    memcpy(pager->queue, pager->pending, sizeof(int) * count);
+    pager->queue_head = 0;
+    pager->queue_count = count;
+}
+
+// call once per frame. finds visible chunks, queues loads for missing ones
+// (nearest first, by this frame's distances) and returns how many chunks are
+// ready to draw. never waits on the loader.
+int pager_update(Pager* pager, const Matrix* camera_pos) {
+    pager->frame++;
+    pager->num_visible = 0;
+    pager->num_drawable = 0;
+    pager_collect(pager, 0, camera_pos);
+    qsort(pager->visible, pager->num_visible, sizeof(PagerVisible), pager_compare_visible);
+    for (int i = 0; i < pager->num_visible; i++) {
+        pager->chunk_ranks[pager->visible[i].chunk] = i;
+    }
+
+    SDL_LockMutex(pager->lock);
+
+    // frees slots of stale loads before looking for slots below
+    pager_requeue(pager);
+
+    // touch everything in view first so nothing visible gets evicted below
+    for (int i = 0; i < pager->num_visible; i++) {
+        const int index = pager->chunk_slots[pager->visible[i].chunk];
+        if (index < 0) {
+            continue;
+        }
+        PagerSlot* slot = &pager->slots[index];
+        slot->last_used = pager->frame;
+        if (slot->state == SLOT_READY && pager->num_drawable < pager->num_slots) {
+            pager->drawable[pager->num_drawable++] = index;
+        }
+    }
+
+    int queued = 0;
+    for (int i = 0; i < pager->num_visible; i++) {
+        const int chunk = pager->visible[i].chunk;
+        if (pager->chunk_slots[chunk] >= 0) {
+            continue;
+        }
+
+        const int index = pager_find_slot(pager);
+        if (index < 0) {
+            break; // pool is full of chunks needed this frame
+        }
+        PagerSlot* slot = &pager->slots[index];
+        if (slot->chunk >= 0) {
+            pager->chunk_slots[slot->chunk] = -1;
+            pager->num_evictions++;
+        }
+        pager->num_loads++;
+        slot->chunk = chunk;
+        slot->state = SLOT_LOADING;
+        slot->last_used = pager->frame;
+        pager->chunk_slots[chunk] = index;
+
+        pager->queue[(pager->queue_head + pager->queue_count) % pager->num_slots] = index;
+        pager->queue_count++;
+        queued = 1;
+    }
+    if (queued) {
+        pager_requeue(pager); // new loads may be nearer than ones already waiting
+        SDL_CondSignal(pager->wake);
+    }
+
+    SDL_UnlockMutex(pager->lock);
+
+    for (int i = 0; i < pager->num_visible; i++) {
+        pager->chunk_ranks[pager->visible[i].chunk] = -1;
+    }
+    return pager->num_drawable;
+}
+
+// stops the loader and frees everything. safe on a partially opened pager.
+void pager_close(Pager* pager) {
+    if (pager == NULL) {
+        return;
+    }
+
+    if (pager->thread != NULL) {
+        SDL_LockMutex(pager->lock);
+        pager->running = 0;
+        SDL_CondSignal(pager->wake);
+        SDL_UnlockMutex(pager->lock);
+        SDL_WaitThread(pager->thread, NULL);
+    }
+    if (pager->wake != NULL) {
+        SDL_DestroyCond(pager->wake);
+    }
+    if (pager->lock != NULL) {
+        SDL_DestroyMutex(pager->lock);
+    }
+
+    if (pager->slots != NULL) {
+        for (int i = 0; i < pager->num_slots; i++) {
+            free_indexed_mesh(pager->slots[i].mesh);
+        }
+    }
+    free(pager->slots);
+    free(pager->queue);
+    free(pager->pending);
+    free(pager->drawable);
+    free(pager->visible);
+    free(pager->chunk_slots);
+    free(pager->chunk_ranks);
+    free(pager->nodes);
+    free(pager->chunks);
+    if (pager->file != NULL) {
+        fclose(pager->file);
+    }
+    free(pager);
+}
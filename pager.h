@@ -0,0 +1,72 @@
+#ifndef PAGER_H
+#define PAGER_H
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "chunkfile.h"
+#include "geometry.h"
+#include "linear.h"
+
+// pages chunks of a chunk file in and out of a fixed pool of slots.
+// the render thread picks which chunks it wants, a loader thread does all
+// file i/o, so pager_update never waits on the disk.
+
+typedef enum {
+    SLOT_FREE,
+    SLOT_LOADING,           // owned by the loader thread
+    SLOT_READY
+} SlotState;
+
+typedef struct {
+    int chunk;              // -1 when free
+    SlotState state;
+    unsigned int last_used; // frame stamp for lru eviction
+    IndexedMesh* mesh;
+} PagerSlot;
+
+typedef struct {
+    double distance;        // from the camera to the chunk's bounding sphere
+    int chunk;
+} PagerVisible;
+
+typedef struct {
+    FILE* file;             // only touched by the loader thread after open
+    ChunkFileHeader header;
+    ChunkNode* nodes;
+    ChunkInfo* chunks;
+    int* chunk_slots;       // slot holding each chunk, -1 if not resident
+    int* chunk_ranks;       // scratch: position in this frame's visible list, -1 if not visible
+
+    int num_slots;
+    PagerSlot* slots;
+    int* queue;             // ring of slots waiting for the loader, nearest first
+    int queue_head;
+    int queue_count;
+    int* pending;           // scratch for reordering the queue
+
+    unsigned int frame;
+    unsigned int num_loads;     // totals, for benchmarks
+    unsigned int num_evictions;
+    PagerVisible* visible;  // scratch: chunks in view this frame, nearest first
+    int num_visible;
+    int* drawable;          // slots that are ready and in view this frame
+    int num_drawable;
+
+    int running;
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_cond* wake;
+} Pager;
+
+size_t pager_slot_bytes(int max_chunk_triangles);
+Pager* pager_open(const char* path, size_t budget_bytes);
+int pager_update(Pager* pager, const Matrix* camera_pos);
+void pager_close(Pager* pager);
+
+// only valid until the next pager_update.
+static inline const IndexedMesh* pager_drawable(const Pager* pager, int index) {
+    return pager->slots[pager->drawable[index]].mesh;
+}
+
+#endif // ! PAGER_H
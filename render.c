@@ -1,4 +1,6 @@
 #include "render.h"
+#include "transform.h"
+#include "video.h"
 
 /**
  * Calculates the edge function for three vertices.
@@ -48,6 +50,12 @@ void draw_triangle(SDL_Renderer* renderer, const Triangle* tri, const double lig
     int min_y = (int)fmin(fmin(ay, by), cy);
     int max_x = (int)fmax(fmax(ax, bx), cx);
     int max_y = (int)fmax(fmax(ay, by), cy);
+
+    // nothing outside the screen gets drawn, so don't scan it
+    min_x = (int)fmax(min_x, 0);
+    min_y = (int)fmax(min_y, 0);
+    max_x = (int)fmin(max_x, SCREEN_WIDTH - 1);
+    max_y = (int)fmin(max_y, SCREEN_HEIGHT - 1);
     
     // Save current renderer color
     Uint8 oldr, oldg, oldb, olda;
@@ -180,3 +188,77 @@ void draw_triangle(SDL_Renderer* renderer, const Triangle* tri, const double lig
     SDL_SetRenderDrawColor(renderer, oldr, oldg, oldb, olda);
     free_matrix(p);
 }
+
+/**
+ * Transforms, culls, lights, projects and draws every triangle of an indexed mesh.
+ * world places the mesh in camera space, proj_matrix is the 3x4 projection.
+ * view and screen are scratch streams with room for every mesh vertex, so
+ * each vertex goes through the batch transform once instead of per triangle.
+ * Returns status code, nothing is drawn if the scratch streams are too small.
+ */
+int draw_indexed_mesh(SDL_Renderer* renderer, const IndexedMesh* mesh, const double world[16],
+                      const Matrix* proj_matrix, const Matrix* camera_pos,
+                      VertexStream* view, VertexStream* screen) {
+    double clip[16];
+    transform_clip_matrix(clip, proj_matrix, world);
+    if (transform_points(world, mesh->positions, view)
+            || transform_project(clip, mesh->positions, screen, SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        return 1;
+    }
+
+    const double cam_x = matrix_get(camera_pos, 0, 0);
+    const double cam_y = matrix_get(camera_pos, 1, 0);
+    const double cam_z = matrix_get(camera_pos, 2, 0);
+
+    // stack matrices wrapping the current triangle for draw_triangle
+    double vert_data[3][3], color_data[3][3];
+    Matrix verts[3], colors[3];
+    Triangle tri;
+    for (int j = 0; j < 3; j++) {
+        verts[j] = (Matrix){.rows = 3, .cols = 1, .data = vert_data[j]};
+        colors[j] = (Matrix){.rows = 3, .cols = 1, .data = color_data[j]};
+        tri.vertices[j] = &verts[j];
+        tri.colors[j] = &colors[j];
+    }
+
+    for (int i = 0; i < mesh->num_triangles; i++) {
+        const int* idx = &mesh->indices[i * 3];
+
+        // no clipping yet, so anything reaching past the near plane is dropped
+        if (view->z[idx[0]] < ZNEAR || view->z[idx[1]] < ZNEAR || view->z[idx[2]] < ZNEAR) {
+            continue;
+        }
+
+        // normal = (v0 - v1) x (v2 - v1) in camera space
+        const double ax = view->x[idx[0]] - view->x[idx[1]];
+        const double ay = view->y[idx[0]] - view->y[idx[1]];
+        const double az = view->z[idx[0]] - view->z[idx[1]];
+        const double bx = view->x[idx[2]] - view->x[idx[1]];
+        const double by = view->y[idx[2]] - view->y[idx[1]];
+        const double bz = view->z[idx[2]] - view->z[idx[1]];
+        const double nx = ay * bz - az * by;
+        const double ny = az * bx - ax * bz;
+        const double nz = ax * by - ay * bx;
+
+        const double to_x = view->x[idx[0]] - cam_x;
+        const double to_y = view->y[idx[0]] - cam_y;
+        const double to_z = view->z[idx[0]] - cam_z;
+        if (nx * to_x + ny * to_y + nz * to_z <= 0.0) {
+            continue;
+        }
+
+        // light points down +z, so the factor is the z of the unit normal
+        const double light_factor = nz / sqrt(nx * nx + ny * ny + nz * nz);
+
+        for (int j = 0; j < 3; j++) {
+            vert_data[j][0] = screen->x[idx[j]];
+            vert_data[j][1] = screen->y[idx[j]];
+            vert_data[j][2] = screen->z[idx[j]];
+            color_data[j][0] = mesh->colors->x[i * 3 + j];
+            color_data[j][1] = mesh->colors->y[i * 3 + j];
+            color_data[j][2] = mesh->colors->z[i * 3 + j];
+        }
+        draw_triangle(renderer, &tri, light_factor);
+    }
+    return 0;
+}
@@ -5,7 +5,9 @@
 #include "linear.h"
 #include <SDL2/SDL.h>
 
-static inline double edge_function(const Matrix* a, const Matrix* b, const Matrix* c);
 void draw_triangle(SDL_Renderer* renderer, const Triangle* tri, const double light_factor);
+int draw_indexed_mesh(SDL_Renderer* renderer, const IndexedMesh* mesh, const double world[16],
+                      const Matrix* proj_matrix, const Matrix* camera_pos,
+                      VertexStream* view, VertexStream* screen);
 
 #endif // !RENDER_H
@@ -0,0 +1,121 @@
+#include "scene.h"
+
+// make sure to free after done with scene.
+// returns null if error.
+SceneGraph* scene_new(int capacity) {
+    SceneGraph* scene = (SceneGraph*)malloc(sizeof(SceneGraph));
+    if (scene == NULL) {
+        fprintf(stderr, "Error allocating memory for scene\n");
+        return NULL;
+    }
+
+    scene->num_nodes = 0;
+    scene->capacity = capacity;
+    scene->first_dirty = 0;
+    scene->parents = (int*)malloc(sizeof(int) * capacity);
+    scene->dirty = (unsigned char*)malloc(sizeof(unsigned char) * capacity);
+    scene->locals = (double*)malloc(sizeof(double) * 16 * capacity);
+    scene->worlds = (double*)malloc(sizeof(double) * 16 * capacity);
+    if (scene->parents == NULL || scene->dirty == NULL || scene->locals == NULL || scene->worlds == NULL) {
+        fprintf(stderr, "Error allocating memory for scene nodes\n");
+        free_scene(scene);
+        return NULL;
+    }
+
+    return scene;
+}
+
+// parent must already be in the scene (or -1 for a root), which keeps the
+// arrays in topological order. returns the node index, -1 if error.
+int scene_add_node(SceneGraph* scene, int parent, const double local[16]) {
+    if (scene == NULL || local == NULL) {
+        fprintf(stderr, "Cannot call scene_add_node on a null scene/matrix\n");
+        return -1;
+    }
+    if (scene->num_nodes >= scene->capacity) {
+        fprintf(stderr, "Scene is full: capacity of %d nodes\n", scene->capacity);
+        return -1;
+    }
+    if (parent < -1 || parent >= scene->num_nodes) {
+        fprintf(stderr, "Invalid scene parent: %d with %d nodes\n", parent, scene->num_nodes);
+        return -1;
+    }
+
+    const int node = scene->num_nodes++;
+    scene->parents[node] = parent;
+    scene->dirty[node] = 1;
+    for (int i = 0; i < 16; i++) {
+        scene->locals[node * 16 + i] = local[i];
+    }
+    if (node < scene->first_dirty) {
+        scene->first_dirty = node;
+    }
+
+    return node;
+}
+
+void scene_set_local(SceneGraph* scene, int node, const double local[16]) {
+    if (scene == NULL || local == NULL) {
+        fprintf(stderr, "Cannot call scene_set_local on a null scene/matrix\n");
+        return;
+    }
+    if (node < 0 || node >= scene->num_nodes) {
+        fprintf(stderr, "Scene node out of bounds: %d in a scene of size %d\n", node, scene->num_nodes);
+        return;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        scene->locals[node * 16 + i] = local[i];
+    }
+    scene->dirty[node] = 1;
+    if (node < scene->first_dirty) {
+        scene->first_dirty = node;
+    }
+}
+
+// recomputes world matrices of dirty nodes and their descendants.
+// nodes before first_dirty are untouched, so a static scene costs nothing.
+void scene_update(SceneGraph* scene) {
+    if (scene == NULL) {
+        return;
+    }
+
+    const int start = scene->first_dirty;
+    for (int node = start; node < scene->num_nodes; node++) {
+        const int parent = scene->parents[node];
+        if (parent >= 0 && scene->dirty[parent]) {
+            scene->dirty[node] = 1; // parent moved so the whole subtree moves
+        }
+        if (!scene->dirty[node]) {
+            continue;
+        }
+
+        double* world = &scene->worlds[node * 16];
+        const double* local = &scene->locals[node * 16];
+        if (parent < 0) {
+            for (int i = 0; i < 16; i++) {
+                world[i] = local[i];
+            }
+        } else {
+            mat4_mult(world, &scene->worlds[parent * 16], local);
+        }
+    }
+
+    // flags can only be cleared once every child has seen its parent's
+    for (int node = start; node < scene->num_nodes; node++) {
+        scene->dirty[node] = 0;
+    }
+    scene->first_dirty = scene->num_nodes;
+}
+
+void free_scene(SceneGraph* scene) {
+    if (scene == NULL) {
+        return;
+    }
+
+    free(scene->parents);
+    free(scene->dirty);
+    free(scene->locals);
+    free(scene->worlds);
+    free(scene);
+}
@@ -0,0 +1,35 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "linear.h"
+
+// flat scene graph. nodes are stored in topological order (a parent always
+// comes before its children) so one forward pass updates every world matrix.
+typedef struct {
+    int num_nodes;
+    int capacity;
+    int first_dirty;        // lowest dirty index, num_nodes if nothing changed
+    int* parents;           // -1 for root nodes
+    unsigned char* dirty;
+    double* locals;         // 16 doubles per node, row-major
+    double* worlds;         // 16 doubles per node, contiguous for streaming
+} SceneGraph;
+
+SceneGraph* scene_new(int capacity);
+int scene_add_node(SceneGraph* scene, int parent, const double local[16]);
+void scene_set_local(SceneGraph* scene, int node, const double local[16]);
+void scene_update(SceneGraph* scene);
+void free_scene(SceneGraph* scene);
+
+static inline const double* scene_local(const SceneGraph* scene, int node) {
+    return &scene->locals[node * 16];
+}
+
+// only valid after scene_update.
+static inline const double* scene_world(const SceneGraph* scene, int node) {
+    return &scene->worlds[node * 16];
+}
+
+#endif // ! SCENE_H
@@ -0,0 +1,27 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// minimal assertions for the unit test executables. a failed check is
+// reported and counted, not fatal, so one run shows every broken check.
+// main returns check_report().
+
+static int check_count = 0;
+static int check_failures = 0;
+
+#define CHECK(cond) do { \
+    check_count++; \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        check_failures++; \
+    } \
+} while (0)
+
+// returns status code.
+static inline int check_report(const char* name) {
+    printf("%s: %d/%d checks passed\n", name, check_count - check_failures, check_count);
+    return check_failures > 0;
+}
+
+#endif // ! CHECK_H
@@ -0,0 +1,217 @@
+#include "check.h"
+#include "chunkfile.h"
+#include "cube.h"
+#include <string.h>
+
+// round trip of a packed grid, then corrupt copies that chunkfile_read_index
+// has to reject before the pager ever sees them.
+
+#define GRID 4
+#define MAX_CHUNK_TRIANGLES 48
+#define GOOD_PATH "chunkfile_test.chunks"
+#define BAD_PATH "chunkfile_test_bad.chunks"
+
+static IndexedMesh* grid_new(void) {
+    IndexedMesh* grid = indexed_mesh_new(CUBE_TRIANGLES * GRID * GRID * GRID, CUBE_VERTICES * GRID * GRID * GRID);
+    if (grid == NULL) {
+        return NULL;
+    }
+    for (int c = 0; c < GRID * GRID * GRID; c++) {
+        cube_mesh_set(grid, c, (c % GRID) * 3.0, (c / GRID % GRID) * 3.0, (c / (GRID * GRID)) * 3.0 + 5.0);
+    }
+    return grid;
+}
+
+// returns file contents, null if error. make sure to free.
+static unsigned char* read_file(const char* path, long* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char* bytes = (unsigned char*)malloc(*size);
+    if (bytes != NULL && fread(bytes, 1, *size, file) != (size_t)*size) {
+        free(bytes);
+        bytes = NULL;
+    }
+    fclose(file);
+    return bytes;
+}
+
+// writes bytes to BAD_PATH and returns chunkfile_read_index's status code.
+static int read_variant(const unsigned char* bytes, long size) {
+    FILE* file = fopen(BAD_PATH, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    fwrite(bytes, 1, size, file);
+    fclose(file);
+
+    file = fopen(BAD_PATH, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    ChunkFileHeader header;
+    ChunkNode* nodes;
+    ChunkInfo* chunks;
+    const int status = chunkfile_read_index(file, &header, &nodes, &chunks);
+    CHECK(status == 0 || (nodes == NULL && chunks == NULL));
+    free(nodes);
+    free(chunks);
+    fclose(file);
+    return status;
+}
+
+static ChunkNode* node_at(unsigned char* bytes, int node) {
+    return (ChunkNode*)(bytes + sizeof(ChunkFileHeader) + sizeof(ChunkNode) * node);
+}
+
+static ChunkInfo* chunk_at(unsigned char* bytes, const ChunkFileHeader* header, int chunk) {
+    return (ChunkInfo*)(bytes + sizeof(ChunkFileHeader) + sizeof(ChunkNode) * header->num_nodes
+                        + sizeof(ChunkInfo) * chunk);
+}
+
+int main(void) {
+    IndexedMesh* grid = grid_new();
+    CHECK(grid != NULL);
+    if (grid == NULL || chunkfile_write(GOOD_PATH, grid, MAX_CHUNK_TRIANGLES)) {
+        CHECK(0);
+        free_indexed_mesh(grid);
+        return check_report("chunkfile_test");
+    }
+
+    // round trip: every triangle lands in exactly one chunk, inside its leaf's bounds
+    FILE* file = fopen(GOOD_PATH, "rb");
+    ChunkFileHeader header;
+    ChunkNode* nodes = NULL;
+    ChunkInfo* chunks = NULL;
+    CHECK(file != NULL && chunkfile_read_index(file, &header, &nodes, &chunks) == 0);
+    if (nodes == NULL || chunks == NULL) {
+        free_indexed_mesh(grid);
+        return check_report("chunkfile_test");
+    }
+    CHECK(header.num_chunks > 1);
+    CHECK(header.max_chunk_triangles <= MAX_CHUNK_TRIANGLES);
+
+    IndexedMesh* chunk_mesh = indexed_mesh_new(header.max_chunk_triangles, 3 * header.max_chunk_triangles);
+    int total = 0, leaves = 0;
+    for (int node = 0; node < header.num_nodes && chunk_mesh != NULL; node++) {
+        const ChunkNode* n = &nodes[node];
+        if (n->chunk < 0) {
+            continue;
+        }
+        leaves++;
+        CHECK(chunkfile_read_chunk(file, &chunks[n->chunk], chunk_mesh) == 0);
+        total += chunk_mesh->num_triangles;
+        int inside = 1;
+        for (int i = 0; i < 3 * chunk_mesh->num_triangles; i++) {
+            const double v[3] = {chunk_mesh->positions->x[i], chunk_mesh->positions->y[i], chunk_mesh->positions->z[i]};
+            for (int axis = 0; axis < 3; axis++) {
+                inside &= v[axis] >= n->min[axis] && v[axis] <= n->max[axis];
+            }
+        }
+        CHECK(inside);
+    }
+    CHECK(leaves == header.num_chunks);
+    CHECK(total == grid->num_triangles);
+    free_indexed_mesh(chunk_mesh);
+    fclose(file);
+
+    long size = 0;
+    unsigned char* good = read_file(GOOD_PATH, &size);
+    unsigned char* bad = (unsigned char*)malloc(size);
+    CHECK(good != NULL && bad != NULL);
+    if (good != NULL && bad != NULL) {
+        // node tail padding is written as zeros
+        for (int node = 0; node < header.num_nodes; node++) {
+            const unsigned char* end = (const unsigned char*)&node_at(good, node)->chunk + sizeof(int);
+            const unsigned char* next = (const unsigned char*)node_at(good, node + 1);
+            int zero = 1;
+            for (const unsigned char* p = end; p < next; p++) {
+                zero &= *p == 0;
+            }
+            CHECK(zero);
+        }
+
+        memcpy(bad, good, size);
+        CHECK(read_variant(bad, size) == 0);
+
+        // two leaves sharing a chunk
+        int first_leaf = -1, second_leaf = -1;
+        for (int node = 0; node < header.num_nodes; node++) {
+            if (nodes[node].chunk >= 0) {
+                if (first_leaf < 0) {
+                    first_leaf = node;
+                } else if (second_leaf < 0) {
+                    second_leaf = node;
+                }
+            }
+        }
+        CHECK(second_leaf > 0);
+        memcpy(bad, good, size);
+        node_at(bad, second_leaf)->chunk = nodes[first_leaf].chunk;
+        CHECK(read_variant(bad, size) == 1);
+
+        // a child pointing at its parent, and at a node before it
+        int interior = -1, slot = -1;
+        for (int node = header.num_nodes - 1; node >= 0 && interior < 0; node--) {
+            for (int octant = 0; octant < 8; octant++) {
+                if (nodes[node].children[octant] >= 0) {
+                    interior = node;
+                    slot = octant;
+                    break;
+                }
+            }
+        }
+        CHECK(interior > 0);
+        memcpy(bad, good, size);
+        node_at(bad, interior)->children[slot] = interior;
+        CHECK(read_variant(bad, size) == 1);
+        memcpy(bad, good, size);
+        node_at(bad, interior)->children[slot] = interior - 1;
+        CHECK(read_variant(bad, size) == 1);
+        memcpy(bad, good, size);
+        node_at(bad, interior)->children[slot] = header.num_nodes;
+        CHECK(read_variant(bad, size) == 1);
+
+        // leaf that also has children
+        memcpy(bad, good, size);
+        node_at(bad, first_leaf)->children[0] = header.num_nodes - 1;
+        CHECK(read_variant(bad, size) == 1);
+
+        // chunk index out of range
+        memcpy(bad, good, size);
+        node_at(bad, first_leaf)->chunk = header.num_chunks;
+        CHECK(read_variant(bad, size) == 1);
+
+        // payload past the end of the file: truncated, or offset moved
+        CHECK(read_variant(good, size - 1) == 1);
+        memcpy(bad, good, size);
+        chunk_at(bad, &header, 0)->offset = size - 8;
+        CHECK(read_variant(bad, size) == 1);
+        memcpy(bad, good, size);
+        chunk_at(bad, &header, 0)->offset = -1;
+        CHECK(read_variant(bad, size) == 1);
+
+        // more triangles than the header allows
+        memcpy(bad, good, size);
+        chunk_at(bad, &header, 0)->num_triangles = header.max_chunk_triangles + 1;
+        CHECK(read_variant(bad, size) == 1);
+
+        // header lies about the table sizes
+        memcpy(bad, good, size);
+        ((ChunkFileHeader*)bad)->num_nodes = 1 << 30;
+        CHECK(read_variant(bad, size) == 1);
+    }
+
+    free(good);
+    free(bad);
+    free(nodes);
+    free(chunks);
+    free_indexed_mesh(grid);
+    remove(GOOD_PATH);
+    remove(BAD_PATH);
+    return check_report("chunkfile_test");
+}
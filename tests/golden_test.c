@@ -0,0 +1,284 @@
+#include "cube.h"
+#include "framebuffer.h"
+#include "geometry.h"
+#include "linear.h"
+#include "render.h"
+#include "scene.h"
+#include "transform.h"
+#include "video.h"
+#include <string.h>
+
+// golden image tests. every canonical scene is drawn headless and compared
+// against <golden dir>/<name>.ppm, printing the diff count and render time.
+// a failing scene leaves <name>.diff.ppm in the working directory.
+//   golden_test <golden dir> [--update]
+// --update rewrites the references instead of comparing.
+
+// pixel-exact: every build rasterizes the same pixels (see -ffp-contract in
+// CMakeLists.txt), so the only slack is rounding in the interpolated colors.
+#define GOLDEN_CHANNEL_TOLERANCE 1
+#define GOLDEN_PATH_MAX 512
+
+// fills world with the scene's model matrix. returns null if error.
+typedef IndexedMesh* (*SceneBuilder)(double world[16]);
+
+typedef struct {
+    const char* name;
+    SceneBuilder build;
+} GoldenScene;
+
+// triangle soup: 3 positions and 3 colors per triangle, indices 0, 1, 2, ...
+static IndexedMesh* soup_new(int num_triangles, const double positions[][3], const double colors[][3]) {
+    IndexedMesh* mesh = indexed_mesh_new(num_triangles, 3 * num_triangles);
+    if (mesh == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < 3 * num_triangles; i++) {
+        mesh->indices[i] = i;
+        vertex_stream_set(mesh->positions, i, positions[i][0], positions[i][1], positions[i][2]);
+        vertex_stream_set(mesh->colors, i, colors[i][0], colors[i][1], colors[i][2]);
+    }
+    return mesh;
+}
+
+// main's cube after a fixed number of frames.
+static IndexedMesh* cube_after(double world[16], int frames) {
+    SceneGraph* scene = scene_new(2);
+    const int node = cube_scene_add(scene);
+    if (node < 0) {
+        free_scene(scene);
+        return NULL;
+    }
+
+    double rot[16];
+    cube_spin_matrix(rot);
+    for (int frame = 0; frame < frames; frame++) {
+        cube_spin(scene, node, rot);
+    }
+    scene_update(scene);
+    for (int i = 0; i < 16; i++) {
+        world[i] = scene_world(scene, node)[i];
+    }
+    free_scene(scene);
+
+    return cube_mesh_new();
+}
+
+static IndexedMesh* cube_000(double world[16]) {
+    return cube_after(world, 0);
+}
+
+static IndexedMesh* cube_050(double world[16]) {
+    return cube_after(world, 50);
+}
+
+static IndexedMesh* cube_629(double world[16]) {
+    return cube_after(world, 629);
+}
+
+// 3x3 grid of quads, every interior edge shared by two triangles.
+// cracks or double-drawn edges show up along the seams.
+static IndexedMesh* edge_quads(double world[16]) {
+    double positions[9 * 6][3], colors[9 * 6][3];
+    const double corner_colors[4][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 255}};
+
+    int v = 0;
+    for (int qy = 0; qy < 3; qy++) {
+        for (int qx = 0; qx < 3; qx++) {
+            const double x0 = qx - 1.5, x1 = qx - 0.5;
+            const double y0 = qy - 1.5, y1 = qy - 0.5;
+            // corners 00, 01, 11 then 00, 11, 10 (clockwise on screen)
+            const double quad[6][2] = {{x0, y0}, {x0, y1}, {x1, y1}, {x0, y0}, {x1, y1}, {x1, y0}};
+            const int color_ids[6] = {0, 1, 2, 0, 2, 3};
+            for (int i = 0; i < 6; i++, v++) {
+                positions[v][0] = quad[i][0];
+                positions[v][1] = quad[i][1];
+                positions[v][2] = 0;
+                for (int c = 0; c < 3; c++) {
+                    colors[v][c] = corner_colors[color_ids[i]][c];
+                }
+            }
+        }
+    }
+
+    mat4_identity(world);
+    world[11] = 4.0;
+    return soup_new(9 * 2, positions, colors);
+}
+
+// zero-area triangles (collinear and repeated vertices) next to slivers a
+// fraction of a pixel wide, both vertical and horizontal.
+static IndexedMesh* slivers(double world[16]) {
+    double positions[12 * 3][3], colors[12 * 3][3];
+    int v = 0;
+
+    const double degenerate[2][3][3] = {
+        {{-1, -1, 0}, {0, 0, 0}, {1, 1, 0}},
+        {{-1, 1, 0}, {-1, 1, 0}, {1, -1, 0}}
+    };
+    for (int t = 0; t < 2; t++) {
+        for (int i = 0; i < 3; i++, v++) {
+            for (int c = 0; c < 3; c++) {
+                positions[v][c] = degenerate[t][i][c];
+                colors[v][c] = 255;
+            }
+        }
+    }
+
+    // vertical slivers, each a little wider than the last
+    for (int k = 0; k < 8; k++) {
+        const double x0 = -1.2 + 0.3 * k, x1 = x0 + 0.0015 * (k + 1);
+        const double tri[3][3] = {{x0, -1, 0}, {x0, 1, 0}, {x1, 1, 0}};
+        for (int i = 0; i < 3; i++, v++) {
+            for (int c = 0; c < 3; c++) {
+                positions[v][c] = tri[i][c];
+            }
+            colors[v][0] = 255;
+            colors[v][1] = 32 * k;
+            colors[v][2] = 0;
+        }
+    }
+
+    // horizontal slivers
+    for (int k = 0; k < 2; k++) {
+        const double y0 = 1.1 + 0.1 * k, y1 = y0 + 0.002 * (k + 1);
+        const double tri[3][3] = {{-1.2, y0, 0}, {-1.2, y1, 0}, {1.2, y1, 0}};
+        for (int i = 0; i < 3; i++, v++) {
+            for (int c = 0; c < 3; c++) {
+                positions[v][c] = tri[i][c];
+            }
+            colors[v][0] = 0;
+            colors[v][1] = 255;
+            colors[v][2] = 255;
+        }
+    }
+
+    mat4_identity(world);
+    world[11] = 3.0;
+    return soup_new(12, positions, colors);
+}
+
+// geometry around the near plane: one triangle safely in front, one just past
+// the near plane that covers most of the screen, one with a vertex behind the
+// near plane and one crossing the camera plane (w = 0 at a vertex).
+static IndexedMesh* near_plane(double world[16]) {
+    const double positions[4 * 3][3] = {
+        {-1.4, -0.5, 2.0}, {-1.4, 0.5, 2.0}, {-0.6, 0.5, 2.0},
+        {-0.05, -0.05, 0.2}, {-0.05, 0.3, 0.2}, {0.3, 0.3, 0.2},
+        {-1.0, -1.0, 3.0}, {-1.0, 1.0, 0.05}, {1.0, 1.0, 3.0},
+        {-1.0, -1.0, 1.0}, {-1.0, 1.0, 0.0}, {1.0, 1.0, -1.0}
+    };
+    const double colors[4 * 3][3] = {
+        {255, 0, 0}, {0, 255, 0}, {0, 0, 255},
+        {255, 255, 0}, {0, 255, 255}, {255, 0, 255},
+        {255, 255, 255}, {255, 255, 255}, {255, 255, 255},
+        {128, 128, 128}, {128, 128, 128}, {128, 128, 128}
+    };
+
+    mat4_identity(world);
+    return soup_new(4, positions, colors);
+}
+
+static const GoldenScene scenes[] = {
+    {"cube_000", cube_000},
+    {"cube_050", cube_050},
+    {"cube_629", cube_629},
+    {"edge_quads", edge_quads},
+    {"slivers", slivers},
+    {"near_plane", near_plane}
+};
+
+// returns status code, 1 if the scene failed.
+static int run_scene(const GoldenScene* scene, Framebuffer* fb, const char* golden_dir, int update,
+                     const Matrix* proj_matrix, const Matrix* camera_pos) {
+    double world[16];
+    IndexedMesh* mesh = scene->build(world);
+    if (mesh == NULL) {
+        return 1;
+    }
+    VertexStream* view = vertex_stream_new(mesh->positions->count);
+    VertexStream* screen = vertex_stream_new(mesh->positions->count);
+    if (view == NULL || screen == NULL) {
+        free_vertex_stream(view);
+        free_vertex_stream(screen);
+        free_indexed_mesh(mesh);
+        return 1;
+    }
+
+    SDL_SetRenderDrawColor(fb->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(fb->renderer);
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const int draw_status = draw_indexed_mesh(fb->renderer, mesh, world, proj_matrix, camera_pos, view, screen);
+    SDL_RenderPresent(fb->renderer);
+    const double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    free_vertex_stream(view);
+    free_vertex_stream(screen);
+    free_indexed_mesh(mesh);
+    if (draw_status) {
+        printf("%-12s FAILED, could not draw\n", scene->name);
+        return 1;
+    }
+
+    char path[GOLDEN_PATH_MAX], diff_path[GOLDEN_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s.ppm", golden_dir, scene->name);
+    snprintf(diff_path, sizeof(diff_path), "%s.diff.ppm", scene->name);
+
+    if (update) {
+        const int status = framebuffer_save_ppm(fb, path);
+        printf("%-12s updated %s, render %.3f ms\n", scene->name, path, ms);
+        return status;
+    }
+
+    const FramebufferTolerance tolerance = {
+        .channel = GOLDEN_CHANNEL_TOLERANCE,
+        .pixels = 0
+    };
+    FramebufferDiff diff;
+    if (framebuffer_compare_ppm(fb, path, tolerance, &diff, diff_path)) {
+        printf("%-12s FAILED, could not compare against %s\n", scene->name, path);
+        return 1;
+    }
+
+    printf("%-12s %6d/%d pixels differ (max channel diff %3d), render %.3f ms%s%s\n",
+           scene->name, diff.diff_pixels, diff.num_pixels, diff.max_channel_diff, ms,
+           diff.passed ? "" : "  FAILED, diff written to ", diff.passed ? "" : diff_path);
+    return !diff.passed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "--update") != 0)) {
+        fprintf(stderr, "Usage: %s <golden dir> [--update]\n", argv[0]);
+        return 1;
+    }
+    const int update = argc == 3;
+
+    Matrix* proj_matrix = transform_projection_new();
+    Matrix* camera_pos = matrix_new(3, 1);
+    const double origin[] = {0, 0, 0};
+    matrix_init(camera_pos, origin);
+
+    Framebuffer fb = {
+        .surface = NULL,
+        .renderer = NULL
+    };
+    if (proj_matrix == NULL || camera_pos == NULL || framebuffer_init(&fb, SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        framebuffer_cleanup(&fb);
+        free_matrix(proj_matrix);
+        free_matrix(camera_pos);
+        return 1;
+    }
+
+    const int num_scenes = sizeof(scenes) / sizeof(scenes[0]);
+    int failures = 0;
+    for (int i = 0; i < num_scenes; i++) {
+        failures += run_scene(&scenes[i], &fb, argv[1], update, proj_matrix, camera_pos);
+    }
+    printf("%d/%d scenes %s\n", num_scenes - failures, num_scenes, update ? "updated" : "passed");
+
+    framebuffer_cleanup(&fb);
+    free_matrix(proj_matrix);
+    free_matrix(camera_pos);
+    return failures > 0;
+}
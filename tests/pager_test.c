@@ -0,0 +1,115 @@
+#include "check.h"
+#include "chunkfile.h"
+#include "cube.h"
+#include "pager.h"
+
+// pager with a budget of 2 slots over 3 chunks. each chunk is one cube, far
+// enough from the others that a camera 10 units in front of a cube sees
+// only that cube. so the test picks exactly which chunks are wanted per frame:
+// A, then B, then A again, then C. C has to evict B, the least recently used,
+// not A, which was loaded first.
+
+#define PATH "pager_test.chunks"
+#define NUM_CUBES 3
+#define MAX_WAIT_SECONDS 10.0
+
+// on a diagonal so the octree splits them apart on every axis.
+static const double cube_positions[NUM_CUBES][3] = {{0, 0, 0}, {60, 60, 60}, {200, 200, 200}};
+
+// every resident chunk is mapped back to its slot and there are never more
+// of them than slots.
+static int pager_consistent(const Pager* pager) {
+    int resident = 0;
+    for (int chunk = 0; chunk < pager->header.num_chunks; chunk++) {
+        const int index = pager->chunk_slots[chunk];
+        if (index < 0) {
+            continue;
+        }
+        resident++;
+        if (index >= pager->num_slots || pager->slots[index].chunk != chunk) {
+            return 0;
+        }
+    }
+    return resident <= pager->num_slots;
+}
+
+// chunk holding cube, found by position since the octree reorders triangles.
+static int chunk_of(const Pager* pager, int cube) {
+    for (int chunk = 0; chunk < pager->header.num_chunks; chunk++) {
+        if (fabs(pager->chunks[chunk].center[0] - (cube_positions[cube][0] + 0.5)) < 1e-9) {
+            return chunk;
+        }
+    }
+    return -1;
+}
+
+// updates with the camera in front of cube until its chunk is drawable, like
+// frames would while the loader works.
+// returns 1 if it landed.
+static int look_at(Pager* pager, Matrix* camera_pos, int cube) {
+    matrix_set(camera_pos, 0, 0, cube_positions[cube][0] + 0.5);
+    matrix_set(camera_pos, 1, 0, cube_positions[cube][1] + 0.5);
+    matrix_set(camera_pos, 2, 0, cube_positions[cube][2] - 10.0);
+
+    const Uint64 deadline = SDL_GetPerformanceCounter()
+                          + (Uint64)(MAX_WAIT_SECONDS * (double)SDL_GetPerformanceFrequency());
+    while (SDL_GetPerformanceCounter() < deadline) {
+        const int num_drawable = pager_update(pager, camera_pos);
+        CHECK(pager_consistent(pager));
+        CHECK(num_drawable <= 1);
+        if (num_drawable == 1) {
+            return pager_drawable(pager, 0)->num_triangles == CUBE_TRIANGLES;
+        }
+        SDL_Delay(1);
+    }
+    return 0;
+}
+
+int main(void) {
+    IndexedMesh* mesh = indexed_mesh_new(CUBE_TRIANGLES * NUM_CUBES, CUBE_VERTICES * NUM_CUBES);
+    CHECK(mesh != NULL);
+    if (mesh == NULL) {
+        return check_report("pager_test");
+    }
+    for (int cube = 0; cube < NUM_CUBES; cube++) {
+        cube_mesh_set(mesh, cube, cube_positions[cube][0], cube_positions[cube][1], cube_positions[cube][2]);
+    }
+    CHECK(chunkfile_write(PATH, mesh, CUBE_TRIANGLES) == 0);
+    free_indexed_mesh(mesh);
+
+    Pager* pager = pager_open(PATH, 2 * pager_slot_bytes(CUBE_TRIANGLES));
+    Matrix* camera_pos = matrix_new(3, 1);
+    CHECK(pager != NULL && camera_pos != NULL);
+    if (pager == NULL || camera_pos == NULL) {
+        pager_close(pager);
+        free_matrix(camera_pos);
+        remove(PATH);
+        return check_report("pager_test");
+    }
+    CHECK(pager->header.num_chunks == NUM_CUBES);
+    CHECK(pager->num_slots == 2);
+
+    const int a = chunk_of(pager, 0), b = chunk_of(pager, 1), c = chunk_of(pager, 2);
+    CHECK(a >= 0 && b >= 0 && c >= 0);
+
+    CHECK(look_at(pager, camera_pos, 0));
+    CHECK(look_at(pager, camera_pos, 1));
+    CHECK(pager->chunk_slots[a] >= 0 && pager->chunk_slots[b] >= 0);
+
+    CHECK(look_at(pager, camera_pos, 0)); // a is the most recently used again
+    const int b_slot = pager->chunk_slots[b];
+    CHECK(look_at(pager, camera_pos, 2));
+    CHECK(pager->chunk_slots[b] == -1);
+    CHECK(pager->chunk_slots[a] >= 0);
+    CHECK(pager->chunk_slots[c] == b_slot);
+
+    // and back: now a is the oldest
+    CHECK(look_at(pager, camera_pos, 1));
+    CHECK(pager->chunk_slots[a] == -1);
+    CHECK(pager->chunk_slots[c] >= 0);
+
+    pager_close(pager);
+    free_matrix(camera_pos);
+    remove(PATH);
+    return check_report("pager_test");
+}
@@ -0,0 +1,133 @@
+#include "check.h"
+#include "scene.h"
+#include <string.h>
+
+// dirty flag propagation in the flat scene graph. nodes are laid out so a
+// sibling subtree sits after the moved node, inside the range scene_update
+// walks, and has to be skipped rather than recomputed.
+//
+//   root
+//   +-- mid        (moved)
+//   |   +-- leaf
+//   +-- sibling
+//       +-- sibling_child
+
+#define EPSILON 1e-12
+
+static void translation(double out[16], double x, double y, double z) {
+    mat4_identity(out);
+    out[3] = x;
+    out[7] = y;
+    out[11] = z;
+}
+
+// reference product, written out here so it doesn't depend on mat4_mult.
+static void multiply(double out[16], const double left[16], const double right[16]) {
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            double sum = 0;
+            for (int k = 0; k < 4; k++) {
+                sum += left[row * 4 + k] * right[k * 4 + col];
+            }
+            out[row * 4 + col] = sum;
+        }
+    }
+}
+
+static int matrices_close(const double a[16], const double b[16]) {
+    for (int i = 0; i < 16; i++) {
+        if (fabs(a[i] - b[i]) > EPSILON) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// where the node's origin ends up.
+static int origin_at(const double world[16], double x, double y, double z) {
+    return fabs(world[3] - x) < EPSILON && fabs(world[7] - y) < EPSILON && fabs(world[11] - z) < EPSILON;
+}
+
+int main(void) {
+    double root_local[16], mid_local[16], leaf_local[16], sibling_local[16], sibling_child_local[16];
+    translation(root_local, 1, 0, 0);
+    translation(mid_local, 0, 2, 0);
+    translation(leaf_local, 0, 0, 3);
+    translation(sibling_local, 5, 0, 0);
+    translation(sibling_child_local, 0, 5, 0);
+
+    SceneGraph* scene = scene_new(5);
+    CHECK(scene != NULL);
+    if (scene == NULL) {
+        return check_report("scene_test");
+    }
+    const int root = scene_add_node(scene, -1, root_local);
+    const int mid = scene_add_node(scene, root, mid_local);
+    const int sibling = scene_add_node(scene, root, sibling_local);
+    const int leaf = scene_add_node(scene, mid, leaf_local);
+    const int sibling_child = scene_add_node(scene, sibling, sibling_child_local);
+    CHECK(root == 0 && mid == 1 && sibling == 2 && leaf == 3 && sibling_child == 4);
+
+    // first update computes everything
+    scene_update(scene);
+    double expected[16], tmp[16];
+    translation(expected, 1, 2, 3);
+    CHECK(matrices_close(scene_world(scene, leaf), expected));
+    translation(expected, 6, 5, 0);
+    CHECK(matrices_close(scene_world(scene, sibling_child), expected));
+    CHECK(scene->first_dirty == scene->num_nodes);
+    for (int node = 0; node < scene->num_nodes; node++) {
+        CHECK(!scene->dirty[node]);
+    }
+
+    // poison the sibling subtree's world matrices. if the next update
+    // recomputes them the sentinel is gone.
+    double sibling_world[16], sibling_child_world[16];
+    memcpy(sibling_world, scene_world(scene, sibling), sizeof(sibling_world));
+    memcpy(sibling_child_world, scene_world(scene, sibling_child), sizeof(sibling_child_world));
+    for (int i = 0; i < 16; i++) {
+        scene->worlds[sibling * 16 + i] = -1234.5;
+        scene->worlds[sibling_child * 16 + i] = -1234.5;
+    }
+
+    // move the middle node: quarter turn about z, then up 4
+    const double moved[16] = {
+        0, -1, 0, 0,
+        1, 0, 0, 4,
+        0, 0, 1, 0,
+        0, 0, 0, 1
+    };
+    scene_set_local(scene, mid, moved);
+    CHECK(scene->first_dirty == mid);
+    scene_update(scene);
+
+    multiply(tmp, root_local, moved);
+    multiply(expected, tmp, leaf_local);
+    CHECK(matrices_close(scene_world(scene, mid), tmp));
+    CHECK(matrices_close(scene_world(scene, leaf), expected));
+    CHECK(origin_at(scene_world(scene, leaf), 1, 4, 3));
+    CHECK(matrices_close(scene_world(scene, root), root_local));
+    for (int i = 0; i < 16; i++) {
+        CHECK(scene_world(scene, sibling)[i] == -1234.5);
+        CHECK(scene_world(scene, sibling_child)[i] == -1234.5);
+    }
+    CHECK(scene->first_dirty == scene->num_nodes);
+    for (int node = 0; node < scene->num_nodes; node++) {
+        CHECK(!scene->dirty[node]);
+    }
+
+    // restore the sibling subtree and move the root: now everything moves
+    for (int i = 0; i < 16; i++) {
+        scene->worlds[sibling * 16 + i] = sibling_world[i];
+        scene->worlds[sibling_child * 16 + i] = sibling_child_world[i];
+    }
+    translation(root_local, 0, 0, 10);
+    scene_set_local(scene, root, root_local);
+    scene_update(scene);
+    translation(expected, 5, 5, 10);
+    CHECK(matrices_close(scene_world(scene, sibling_child), expected));
+    CHECK(origin_at(scene_world(scene, leaf), 0, 4, 13));
+
+    free_scene(scene);
+    return check_report("scene_test");
+}
@@ -0,0 +1,118 @@
+#include "check.h"
+#include "transform.h"
+#include "video.h"
+#include <string.h>
+
+// every SIMD kernel the cpu supports must match the scalar kernel, including
+// the scalar tail (counts that are not a multiple of 4) and lanes where w is
+// 0, which are left undivided.
+
+#define MAX_COUNT 19
+#define EPSILON 1e-12
+
+static const char* simd_kernels[] = {"sse2", "avx2"};
+
+// mixes ordinary points with points on the camera plane (w = z = 0 under
+// the clip matrix) at varying lanes.
+static void fill_stream(VertexStream* stream, int count) {
+    for (int i = 0; i < count; i++) {
+        const double z = (i % 3 == 1) ? 0.0 : 0.5 + 0.37 * i;
+        vertex_stream_set(stream, i, -2.0 + 0.31 * i, 1.5 - 0.17 * i, z);
+    }
+    stream->count = count;
+}
+
+static int streams_close(const VertexStream* a, const VertexStream* b, int count) {
+    for (int i = 0; i < count; i++) {
+        const double diffs[3] = {a->x[i] - b->x[i], a->y[i] - b->y[i], a->z[i] - b->z[i]};
+        const double scales[3] = {fabs(a->x[i]), fabs(a->y[i]), fabs(a->z[i])};
+        for (int axis = 0; axis < 3; axis++) {
+            if (fabs(diffs[axis]) > EPSILON * fmax(1.0, scales[axis])) {
+                fprintf(stderr, "vertex %d axis %d: %.17g vs %.17g\n", i, axis,
+                        axis == 0 ? a->x[i] : axis == 1 ? a->y[i] : a->z[i],
+                        axis == 0 ? b->x[i] : axis == 1 ? b->y[i] : b->z[i]);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    // world: small rotation about x plus a shift, clip: projection folded in
+    const double world[16] = {
+        1, 0, 0, 0.25,
+        0, 0.8, -0.6, -0.5,
+        0, 0.6, 0.8, 0,
+        0, 0, 0, 1
+    };
+    double identity4x4[16], clip[16];
+    mat4_identity(identity4x4);
+    Matrix* proj_matrix = transform_projection_new();
+    CHECK(proj_matrix != NULL);
+    if (proj_matrix == NULL) {
+        return check_report("transform_test");
+    }
+    transform_clip_matrix(clip, proj_matrix, identity4x4);
+
+    VertexStream* in = vertex_stream_new(MAX_COUNT);
+    VertexStream* expected = vertex_stream_new(MAX_COUNT);
+    VertexStream* actual = vertex_stream_new(MAX_COUNT);
+    CHECK(in != NULL && expected != NULL && actual != NULL);
+    if (in == NULL || expected == NULL || actual == NULL) {
+        return check_report("transform_test");
+    }
+
+    CHECK(transform_set_kernel("scalar") == 0);
+    CHECK(strcmp(transform_kernel_name(), "scalar") == 0);
+    CHECK(transform_set_kernel("no-such-kernel") == 1);
+    CHECK(strcmp(transform_kernel_name(), "scalar") == 0);
+
+    // w == 0 lanes keep the undivided clip coordinates
+    fill_stream(in, 2);
+    CHECK(transform_project(clip, in, expected, SCREEN_WIDTH, SCREEN_HEIGHT) == 0);
+    CHECK(expected->x[1] == (matrix_get(proj_matrix, 0, 0) * in->x[1] + 1) * 0.5 * SCREEN_WIDTH);
+
+    // too small an output is rejected
+    fill_stream(in, MAX_COUNT);
+    actual->count = MAX_COUNT - 1;
+    CHECK(transform_points(world, in, actual) == 1);
+    CHECK(transform_project(clip, in, actual, SCREEN_WIDTH, SCREEN_HEIGHT) == 1);
+    actual->count = MAX_COUNT;
+
+    int tested = 0;
+    for (size_t k = 0; k < sizeof(simd_kernels) / sizeof(simd_kernels[0]); k++) {
+        const char* name = simd_kernels[k];
+        if (transform_set_kernel(name)) {
+            printf("transform_test: %s not supported here, skipped\n", name);
+            continue;
+        }
+        CHECK(transform_set_kernel("scalar") == 0);
+        tested++;
+
+        for (int count = 1; count <= MAX_COUNT; count++) {
+            fill_stream(in, count);
+
+            transform_set_kernel("scalar");
+            CHECK(transform_points(world, in, expected) == 0);
+            transform_set_kernel(name);
+            CHECK(transform_points(world, in, actual) == 0);
+            CHECK(streams_close(expected, actual, count));
+
+            transform_set_kernel("scalar");
+            CHECK(transform_project(clip, in, expected, SCREEN_WIDTH, SCREEN_HEIGHT) == 0);
+            transform_set_kernel(name);
+            CHECK(strcmp(transform_kernel_name(), name) == 0);
+            CHECK(transform_project(clip, in, actual, SCREEN_WIDTH, SCREEN_HEIGHT) == 0);
+            CHECK(streams_close(expected, actual, count));
+        }
+    }
+    printf("transform_test: %d simd kernel(s) compared against scalar\n", tested);
+
+    CHECK(transform_set_kernel("auto") == 0);
+    free_vertex_stream(in);
+    free_vertex_stream(expected);
+    free_vertex_stream(actual);
+    free_matrix(proj_matrix);
+    return check_report("transform_test");
+}
@@ -0,0 +1,240 @@
+#include "transform.h"
+#include "video.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRANSFORM_X86 1
+#include <immintrin.h>
+#endif
+
+// rows 0-2 of mat are applied to (x, y, z, 1). if project is set, row 3 gives
+// w, xyz are divided by w (skipped when w is 0) and xy are mapped to pixels.
+typedef void (*TransformKernel)(const double mat[16], const VertexStream* in, VertexStream* out,
+                                int start, int project, double width, double height);
+
+static void transform_scalar(const double mat[16], const VertexStream* in, VertexStream* out,
+                             int start, int project, double width, double height) {
+    for (int i = start; i < in->count; i++) {
+        const double x = in->x[i], y = in->y[i], z = in->z[i];
+        double tx = mat[0] * x + mat[1] * y + mat[2] * z + mat[3];
+        double ty = mat[4] * x + mat[5] * y + mat[6] * z + mat[7];
+        double tz = mat[8] * x + mat[9] * y + mat[10] * z + mat[11];
+        if (project) {
+            const double w = mat[12] * x + mat[13] * y + mat[14] * z + mat[15];
+            if (w != 0) {
+                tx /= w;
+                ty /= w;
+                tz /= w;
+            }
+            tx = (tx + 1) * 0.5 * width;
+            ty = (ty + 1) * 0.5 * height;
+        }
+        out->x[i] = tx;
+        out->y[i] = ty;
+        out->z[i] = tz;
+    }
+}
+
+#ifdef TRANSFORM_X86
+// 2 vertices per iteration.
+__attribute__((target("sse2")))
+static void transform_sse2(const double mat[16], const VertexStream* in, VertexStream* out,
+                           int start, int project, double width, double height) {
+    __m128d m[16];
+    for (int i = 0; i < 16; i++) {
+        m[i] = _mm_set1_pd(mat[i]);
+    }
+    const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.0), half = _mm_set1_pd(0.5);
+    const __m128d w_scale = _mm_set1_pd(width), h_scale = _mm_set1_pd(height);
+
+    int i = start;
+    for (; i + 2 <= in->count; i += 2) {
+        const __m128d x = _mm_loadu_pd(&in->x[i]);
+        const __m128d y = _mm_loadu_pd(&in->y[i]);
+        const __m128d z = _mm_loadu_pd(&in->z[i]);
+        __m128d tx = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m[0], x), _mm_mul_pd(m[1], y)), _mm_mul_pd(m[2], z)), m[3]);
+        __m128d ty = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m[4], x), _mm_mul_pd(m[5], y)), _mm_mul_pd(m[6], z)), m[7]);
+        __m128d tz = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m[8], x), _mm_mul_pd(m[9], y)), _mm_mul_pd(m[10], z)), m[11]);
+        if (project) {
+            __m128d w = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m[12], x), _mm_mul_pd(m[13], y)), _mm_mul_pd(m[14], z)), m[15]);
+            const __m128d w_zero = _mm_cmpeq_pd(w, zero);
+            w = _mm_or_pd(_mm_and_pd(w_zero, one), _mm_andnot_pd(w_zero, w)); // divide by 1 instead of 0
+            tx = _mm_div_pd(tx, w);
+            ty = _mm_div_pd(ty, w);
+            tz = _mm_div_pd(tz, w);
+            tx = _mm_mul_pd(_mm_mul_pd(_mm_add_pd(tx, one), half), w_scale);
+            ty = _mm_mul_pd(_mm_mul_pd(_mm_add_pd(ty, one), half), h_scale);
+        }
+        _mm_storeu_pd(&out->x[i], tx);
+        _mm_storeu_pd(&out->y[i], ty);
+        _mm_storeu_pd(&out->z[i], tz);
+    }
+    transform_scalar(mat, in, out, i, project, width, height);
+}
+
+// 4 vertices per iteration.
+__attribute__((target("avx2")))
+static void transform_avx2(const double mat[16], const VertexStream* in, VertexStream* out,
+                           int start, int project, double width, double height) {
+    __m256d m[16];
+    for (int i = 0; i < 16; i++) {
+        m[i] = _mm256_set1_pd(mat[i]);
+    }
+    const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0), half = _mm256_set1_pd(0.5);
+    const __m256d w_scale = _mm256_set1_pd(width), h_scale = _mm256_set1_pd(height);
+
+    int i = start;
+    for (; i + 4 <= in->count; i += 4) {
+        const __m256d x = _mm256_loadu_pd(&in->x[i]);
+        const __m256d y = _mm256_loadu_pd(&in->y[i]);
+        const __m256d z = _mm256_loadu_pd(&in->z[i]);
+        __m256d tx = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m[0], x), _mm256_mul_pd(m[1], y)), _mm256_mul_pd(m[2], z)), m[3]);
+        __m256d ty = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m[4], x), _mm256_mul_pd(m[5], y)), _mm256_mul_pd(m[6], z)), m[7]);
+        __m256d tz = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m[8], x), _mm256_mul_pd(m[9], y)), _mm256_mul_pd(m[10], z)), m[11]);
+        if (project) {
+            __m256d w = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(m[12], x), _mm256_mul_pd(m[13], y)), _mm256_mul_pd(m[14], z)), m[15]);
+            w = _mm256_blendv_pd(w, one, _mm256_cmp_pd(w, zero, _CMP_EQ_OQ)); // divide by 1 instead of 0
+            tx = _mm256_div_pd(tx, w);
+            ty = _mm256_div_pd(ty, w);
+            tz = _mm256_div_pd(tz, w);
+            tx = _mm256_mul_pd(_mm256_mul_pd(_mm256_add_pd(tx, one), half), w_scale);
+            ty = _mm256_mul_pd(_mm256_mul_pd(_mm256_add_pd(ty, one), half), h_scale);
+        }
+        _mm256_storeu_pd(&out->x[i], tx);
+        _mm256_storeu_pd(&out->y[i], ty);
+        _mm256_storeu_pd(&out->z[i], tz);
+    }
+    transform_scalar(mat, in, out, i, project, width, height);
+}
+#endif // TRANSFORM_X86
+
+static TransformKernel kernel = NULL;
+static const char* kernel_name = "scalar";
+
+// returns status code, 1 if the name is unknown or the cpu lacks the kernel.
+static int transform_select(const char* name) {
+    if (strcmp(name, "scalar") == 0) {
+        kernel = transform_scalar;
+        kernel_name = "scalar";
+        return 0;
+    }
+#ifdef TRANSFORM_X86
+    __builtin_cpu_init();
+    if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        kernel = transform_sse2;
+        kernel_name = "sse2";
+        return 0;
+    }
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        kernel = transform_avx2;
+        kernel_name = "avx2";
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+// fastest kernel the cpu supports.
+static void transform_select_auto(void) {
+    if (transform_select("avx2") && transform_select("sse2")) {
+        transform_select("scalar");
+    }
+}
+
+// picked on first use. CUBESOUP_TRANSFORM_KERNEL in the environment forces a
+// kernel the same way transform_set_kernel does.
+static TransformKernel transform_kernel(void) {
+    if (kernel != NULL) {
+        return kernel;
+    }
+
+    const char* forced = getenv("CUBESOUP_TRANSFORM_KERNEL");
+    if (forced == NULL || transform_set_kernel(forced)) {
+        transform_select_auto();
+    }
+    return kernel;
+}
+
+// forces a kernel: "scalar", "sse2", "avx2", or "auto" for the fastest the cpu
+// supports. meant for tests and benchmarks. returns status code, the current
+// kernel is kept if the name is unknown or unsupported.
+int transform_set_kernel(const char* name) {
+    if (name == NULL) {
+        fprintf(stderr, "Cannot select a null transform kernel\n");
+        return 1;
+    }
+    if (strcmp(name, "auto") == 0) {
+        transform_select_auto();
+        return 0;
+    }
+
+    if (transform_select(name)) {
+        fprintf(stderr, "Transform kernel %s is unknown or not supported by this cpu\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+static inline int transform_sizes_valid(const VertexStream* in, const VertexStream* out) {
+    if (in == NULL || out == NULL) {
+        fprintf(stderr, "Cannot transform a null vertex stream\n");
+        return 0;
+    }
+    if (out->count < in->count) {
+        fprintf(stderr, "Vertex stream too small for transform: %d < %d\n", out->count, in->count);
+        return 0;
+    }
+    return 1;
+}
+
+// 3x4 perspective projection for the screen and clip planes in video.h.
+// the camera looks down +z. make sure to free after done with matrix.
+// returns null if error.
+Matrix* transform_projection_new(void) {
+    const double f = 1/tan(FOV_DEG * M_PI / 360.0);
+    const double q = ZFAR / (ZFAR - ZNEAR);
+    Matrix* proj_matrix = matrix_new(3, 4);
+    const double proj_arr[] = {
+        ASPECT_RATIO * f, 0, 0, 0,
+                       0, f, 0, 0,
+                       0, 0, q, -ZNEAR * q
+    };
+    matrix_init(proj_matrix, proj_arr);
+    return proj_matrix;
+}
+
+// folds the 3x4 projection and the world matrix into one 4x4. the last row
+// copies camera-space z so the divide matches projecting a world-space point.
+void transform_clip_matrix(double clip[16], const Matrix* proj_matrix, const double world[16]) {
+    double proj[16];
+    mat4_from_matrix(proj, proj_matrix);
+    for (int col = 0; col < 4; col++) {
+        proj[12 + col] = (col == 2) ? 1.0 : 0.0;
+    }
+    mat4_mult(clip, proj, world);
+}
+
+// out = mat * in, w assumed to be 1. out must hold at least in->count vertices.
+// returns status code.
+int transform_points(const double mat[16], const VertexStream* in, VertexStream* out) {
+    if (!transform_sizes_valid(in, out)) {
+        return 1;
+    }
+    transform_kernel()(mat, in, out, 0, 0, 0, 0);
+    return 0;
+}
+
+// out gets pixel x/y and projected depth. out must hold at least in->count vertices.
+// returns status code.
+int transform_project(const double clip[16], const VertexStream* in, VertexStream* out, int width, int height) {
+    if (!transform_sizes_valid(in, out)) {
+        return 1;
+    }
+    transform_kernel()(clip, in, out, 0, 1, width, height);
+    return 0;
+}
+
+const char* transform_kernel_name(void) {
+    transform_kernel();
+    return kernel_name;
+}
@@ -0,0 +1,18 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "geometry.h"
+#include "linear.h"
+
+// batch vertex transforms over SoA streams. the kernel is picked at runtime
+// (AVX2, SSE2 or scalar) the first time a transform runs, unless forced with
+// transform_set_kernel or CUBESOUP_TRANSFORM_KERNEL.
+
+Matrix* transform_projection_new(void);
+void transform_clip_matrix(double clip[16], const Matrix* proj_matrix, const double world[16]);
+int transform_points(const double mat[16], const VertexStream* in, VertexStream* out);
+int transform_project(const double clip[16], const VertexStream* in, VertexStream* out, int width, int height);
+int transform_set_kernel(const char* name);
+const char* transform_kernel_name(void);
+
+#endif // ! TRANSFORM_H